@@ -0,0 +1,173 @@
+#include <string>
+#include <vector>
+
+#include <jsoncc.h>
+#include "bench.h"
+
+namespace {
+
+// size lookups in an object with members members, like a feature map
+class ObjectLookup : public bench::Benchmark {
+public:
+	ObjectLookup(const char *name, size_t members)
+	:
+		bench::Benchmark(name),
+		members_(members),
+		object_(),
+		keys_()
+	{ }
+
+	void setup(size_t size) override
+	{
+		object_ = Json::Object();
+		for (size_t i(0); i < members_; ++i) {
+			object_ << Json::Member("feature_" + std::to_string(i), uint64_t(i));
+		}
+
+		keys_.clear();
+		for (size_t i(0); i < size; ++i) {
+			// every eighth key is missing
+			keys_.push_back("feature_" + std::to_string(i * 7 % (members_ + members_ / 8)));
+		}
+	}
+
+	void run() override
+	{
+		size_t found(0);
+		for (auto const& key : keys_) {
+			found += bool(object_.as_member(key));
+		}
+		if (found > keys_.size()) {
+			throw 0; // LCOV_EXCL_LINE
+		}
+	}
+
+private:
+	size_t members_;
+	Json::Object object_;
+	std::vector<std::string> keys_;
+};
+
+class ObjectLookupSmall : public ObjectLookup {
+public:
+	ObjectLookupSmall() : ObjectLookup("object lookup 8", 8) { }
+};
+
+class ObjectLookupLarge : public ObjectLookup {
+public:
+	ObjectLookupLarge() : ObjectLookup("object lookup 500", 500) { }
+};
+
+// size copies of a config like tree, handed out to workers
+class ValueCopy : public bench::Benchmark {
+public:
+	ValueCopy()
+	:
+		bench::Benchmark("value copy"),
+		tree_(),
+		copies_()
+	{
+		Json::Array sections;
+		for (int i(0); i < 100; ++i) {
+			sections << Json::Object{
+				{"section_name", "section number " + std::to_string(i)},
+				{"values", Json::Array{i, i + 1, i + 2, "a longer string value"}},
+			};
+		}
+		tree_ = Json::Object{{"sections", std::move(sections)}};
+	}
+
+	void setup(size_t size) override
+	{
+		copies_.clear();
+		copies_.resize(size);
+	}
+
+	void run() override
+	{
+		for (auto & copy : copies_) {
+			copy = tree_;
+		}
+	}
+
+private:
+	Json::Value tree_;
+	std::vector<Json::Value> copies_;
+};
+
+// two objects with size members in opposite order
+class ObjectEqual : public bench::Benchmark {
+public:
+	ObjectEqual()
+	:
+		bench::Benchmark("object equal"),
+		left_(),
+		right_()
+	{ }
+
+	void setup(size_t size) override
+	{
+		left_ = Json::Object();
+		right_ = Json::Object();
+		for (size_t i(0); i < size; ++i) {
+			left_ << Json::Member("setting_" + std::to_string(i), uint64_t(i));
+			right_ << Json::Member("setting_" + std::to_string(size - 1 - i), uint64_t(size - 1 - i));
+		}
+	}
+
+	void run() override
+	{
+		if (!Json::equal(left_, right_)) {
+			throw 0; // LCOV_EXCL_LINE
+		}
+	}
+
+private:
+	Json::Object left_;
+	Json::Object right_;
+};
+
+// hashes of size trees with long strings, without the cache
+class HashValue : public bench::Benchmark {
+public:
+	HashValue()
+	:
+		bench::Benchmark("value hash"),
+		trees_()
+	{ }
+
+	void setup(size_t size) override
+	{
+		trees_.clear();
+		for (size_t i(0); i < size; ++i) {
+			trees_.push_back(Json::Object{
+				{"description", "a description of item " + std::to_string(i) +
+					" which is long enough for several blocks of the string hash"},
+				{"id", uint64_t(i)},
+				{"weights", Json::Array{0.5, 1.5, 2.5}},
+			});
+		}
+	}
+
+	void run() override
+	{
+		size_t sum(0);
+		for (auto const& tree : trees_) {
+			sum += Json::hash(tree);
+		}
+		if (sum == 1) {
+			throw 0; // LCOV_EXCL_LINE
+		}
+	}
+
+private:
+	std::vector<Json::Value> trees_;
+};
+
+}
+
+BENCHMARK_REGISTRATION(ObjectLookupSmall);
+BENCHMARK_REGISTRATION(ObjectLookupLarge);
+BENCHMARK_REGISTRATION(ValueCopy);
+BENCHMARK_REGISTRATION(ObjectEqual);
+BENCHMARK_REGISTRATION(HashValue);
@@ -0,0 +1,445 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <jsoncc.h>
+#include "bench.h"
+
+namespace {
+
+// an array of size records, each a small nested object
+std::string make_text(size_t size)
+{
+	std::string text("[");
+	for (size_t i(0); i < size; ++i) {
+		if (i) {
+			text += ",";
+		}
+		text += "{\"id\": " + std::to_string(i) + ", "
+			"\"name\": \"some moderately long string value\", "
+			"\"ratio\": 0.5, \"enabled\": true, "
+			"\"tags\": [\"alpha\", \"beta\", \"gamma\"], "
+			"\"nested\": {\"key\": \"value\", \"other\": null}}";
+	}
+	text += "]";
+	return text;
+}
+
+// an array of size long strings, like log messages
+std::string make_strings(size_t size)
+{
+	std::string text("[");
+	for (size_t i(0); i < size; ++i) {
+		if (i) {
+			text += ",";
+		}
+		text += "\"2019-03-01T12:00:00Z host-" + std::to_string(i) +
+			" service[1234]: request completed in 15ms, "
+			"status=200 path=/api/v1/items/\\u00e4 "
+			"aGVsbG8gd29ybGQgaGVsbG8gd29ybGQgaGVsbG8gd29ybGQ=\"";
+	}
+	text += "]";
+	return text;
+}
+
+// an array of size telemetry samples
+std::string make_floats(size_t size)
+{
+	std::string text("[");
+	for (size_t i(0); i < size; ++i) {
+		if (i) {
+			text += ",";
+		}
+		text += "[" + std::to_string(i * 0.731) + ", -" + std::to_string(i) + ".125e-3, " +
+			"1.7976931348623157e" + std::to_string(i % 300) + ", 0.1]";
+	}
+	text += "]";
+	return text;
+}
+
+// an array of size ids and timestamps
+std::string make_integers(size_t size)
+{
+	std::string text("[");
+	for (size_t i(0); i < size; ++i) {
+		if (i) {
+			text += ",";
+		}
+		text += "[" + std::to_string(i) + "," + std::to_string(1550000000000 + i * 7919) + ",-" +
+			std::to_string(i * 31) + "]";
+	}
+	text += "]";
+	return text;
+}
+
+class ParseValue : public bench::Benchmark {
+public:
+	ParseValue() : bench::Benchmark("parse value") { }
+
+	void setup(size_t size) override
+	{
+		text_ = make_text(size);
+	}
+
+	void run() override
+	{
+		parser_.parse(text_.data(), text_.size());
+	}
+
+private:
+	Json::Parser parser_;
+	std::string text_;
+};
+
+class ParseDocument : public bench::Benchmark {
+public:
+	ParseDocument() : bench::Benchmark("parse document") { }
+
+	void setup(size_t size) override
+	{
+		text_ = make_text(size);
+	}
+
+	void run() override
+	{
+		parser_.parse(text_.data(), text_.size(), doc_);
+	}
+
+private:
+	Json::Parser parser_;
+	Json::Document doc_;
+	std::string text_;
+};
+
+class ParseStructural : public bench::Benchmark {
+public:
+	ParseStructural() : bench::Benchmark("parse structural") { }
+
+	void setup(size_t size) override
+	{
+		text_ = make_text(size);
+		parser_.set_backend(Json::Parser::STRUCTURAL_INDEX);
+	}
+
+	void run() override
+	{
+		parser_.parse(text_.data(), text_.size(), doc_);
+	}
+
+private:
+	Json::Parser parser_;
+	Json::Document doc_;
+	std::string text_;
+};
+
+class ParseBorrowed : public bench::Benchmark {
+public:
+	ParseBorrowed() : bench::Benchmark("parse borrowed") { }
+
+	void setup(size_t size) override
+	{
+		text_ = make_text(size);
+	}
+
+	void run() override
+	{
+		parser_.parse_borrowed(text_.data(), text_.size(), doc_);
+	}
+
+private:
+	Json::Parser parser_;
+	Json::Document doc_;
+	std::string text_;
+};
+
+// reads a few fields like a request router
+class ParseLazy : public bench::Benchmark {
+public:
+	ParseLazy() : bench::Benchmark("parse lazy"), size_(0), id_(0) { }
+
+	void setup(size_t size) override
+	{
+		text_ = make_text(size);
+		size_ = size;
+	}
+
+	void run() override
+	{
+		parser_.parse(text_.data(), text_.size(), doc_);
+		id_ += doc_[0]["id"].get_int64();
+		id_ += doc_[size_ - 1]["id"].get_int64();
+		name_ = doc_[size_ / 2]["nested"]["key"].get_string();
+	}
+
+private:
+	Json::Parser parser_;
+	Json::LazyDocument doc_;
+	std::string text_;
+	size_t size_;
+	int64_t id_;
+	std::string name_;
+};
+
+// includes restoring the buffer the parse decodes into
+class ParseInsitu : public bench::Benchmark {
+public:
+	ParseInsitu() : bench::Benchmark("parse insitu") { }
+
+	void setup(size_t size) override
+	{
+		text_ = make_strings(size);
+		buffer_ = text_;
+	}
+
+	void run() override
+	{
+		std::copy(text_.begin(), text_.end(), buffer_.begin());
+		parser_.parse_insitu(&buffer_[0], buffer_.size(), doc_);
+	}
+
+private:
+	Json::Parser parser_;
+	Json::Document doc_;
+	std::string text_;
+	std::string buffer_;
+};
+
+// consumes events like a client picking single fields
+class Sink : public Json::Handler {
+public:
+	Sink() : sum(0) { }
+
+	void null() override { }
+	void boolean(bool) override { }
+	void number(int64_t v) override { sum += v; }
+	void number(double) override { }
+	void string(Json::StringView) override { }
+	void start_array() override { }
+	void end_array() override { }
+	void start_object() override { }
+	void key(Json::StringView) override { }
+	void end_object() override { }
+
+	int64_t sum;
+};
+
+class ParseHandler : public bench::Benchmark {
+public:
+	ParseHandler() : bench::Benchmark("parse handler") { }
+
+	void setup(size_t size) override
+	{
+		text_ = make_text(size);
+	}
+
+	void run() override
+	{
+		parser_.parse(text_.data(), text_.size(), sink_);
+	}
+
+private:
+	Json::Parser parser_;
+	Sink sink_;
+	std::string text_;
+};
+
+}
+
+class ParseStrings : public bench::Benchmark {
+public:
+	ParseStrings() : bench::Benchmark("parse strings") { }
+
+	void setup(size_t size) override
+	{
+		text_ = make_strings(size);
+	}
+
+	void run() override
+	{
+		parser_.parse(text_.data(), text_.size());
+	}
+
+private:
+	Json::Parser parser_;
+	std::string text_;
+};
+
+class ParseStringsStructural : public bench::Benchmark {
+public:
+	ParseStringsStructural() : bench::Benchmark("parse strings structural") { }
+
+	void setup(size_t size) override
+	{
+		text_ = make_strings(size);
+		parser_.set_backend(Json::Parser::STRUCTURAL_INDEX);
+	}
+
+	void run() override
+	{
+		parser_.parse(text_.data(), text_.size());
+	}
+
+private:
+	Json::Parser parser_;
+	std::string text_;
+};
+
+class ParseFloats : public bench::Benchmark {
+public:
+	ParseFloats() : bench::Benchmark("parse floats") { }
+
+	void setup(size_t size) override
+	{
+		text_ = make_floats(size);
+	}
+
+	void run() override
+	{
+		parser_.parse(text_.data(), text_.size());
+	}
+
+private:
+	Json::Parser parser_;
+	std::string text_;
+};
+
+class ParseIntegers : public bench::Benchmark {
+public:
+	ParseIntegers() : bench::Benchmark("parse integers") { }
+
+	void setup(size_t size) override
+	{
+		text_ = make_integers(size);
+	}
+
+	void run() override
+	{
+		parser_.parse(text_.data(), text_.size());
+	}
+
+private:
+	Json::Parser parser_;
+	std::string text_;
+};
+
+// size records, one per line
+std::string make_lines(size_t size)
+{
+	std::string text;
+	for (size_t i(0); i < size; ++i) {
+		text += "{\"id\": " + std::to_string(i) + ", "
+			"\"name\": \"some moderately long string value\", "
+			"\"ratio\": 0.5, \"enabled\": true, "
+			"\"tags\": [\"alpha\", \"beta\", \"gamma\"]}\n";
+	}
+	return text;
+}
+
+class ParseNdjson : public bench::Benchmark {
+public:
+	ParseNdjson(const char *name, size_t threads)
+	:
+		bench::Benchmark(name),
+		parser_(threads)
+	{ }
+
+	void setup(size_t size) override
+	{
+		// enough lines for several batches per thread
+		text_ = make_lines(size * 20);
+	}
+
+	void run() override
+	{
+		parser_.parse(text_.data(), text_.size(), [](Json::NdjsonParser::Record &) { });
+	}
+
+private:
+	Json::NdjsonParser parser_;
+	std::string text_;
+};
+
+class ParseNdjsonOne : public ParseNdjson {
+public:
+	ParseNdjsonOne() : ParseNdjson("parse ndjson 1 thread", 1) { }
+};
+
+class ParseNdjsonAll : public ParseNdjson {
+public:
+	ParseNdjsonAll() : ParseNdjson("parse ndjson all threads", 0) { }
+};
+
+// size records with keys too long to be stored in place
+std::string make_keyed_lines(size_t size)
+{
+	std::string text;
+	for (size_t i(0); i < size; ++i) {
+		text += "{\"customer_identifier\": " + std::to_string(i) + ", "
+			"\"registration_timestamp\": 1546300800, "
+			"\"preferred_language_code\": \"de\", "
+			"\"marketing_consent_given\": false}\n";
+	}
+	return text;
+}
+
+// records are kept like by an application collecting them
+class ParseNdjsonKeys : public bench::Benchmark {
+public:
+	ParseNdjsonKeys(const char *name, bool intern)
+	:
+		bench::Benchmark(name),
+		parser_(1),
+		table_(),
+		text_(),
+		values_()
+	{
+		if (intern) {
+			parser_.set_key_table(&table_);
+		}
+	}
+
+	void setup(size_t size) override
+	{
+		text_ = make_keyed_lines(size * 20);
+	}
+
+	void run() override
+	{
+		values_.clear();
+		parser_.parse(text_.data(), text_.size(), [this](Json::NdjsonParser::Record & record) {
+			values_.push_back(std::move(record.value));
+		});
+	}
+
+private:
+	Json::NdjsonParser parser_;
+	Json::KeyTable table_;
+	std::string text_;
+	std::vector<Json::Value> values_;
+};
+
+class ParseNdjsonCopiedKeys : public ParseNdjsonKeys {
+public:
+	ParseNdjsonCopiedKeys() : ParseNdjsonKeys("parse ndjson copied keys", false) { }
+};
+
+class ParseNdjsonInternedKeys : public ParseNdjsonKeys {
+public:
+	ParseNdjsonInternedKeys() : ParseNdjsonKeys("parse ndjson interned keys", true) { }
+};
+
+BENCHMARK_REGISTRATION(ParseValue);
+BENCHMARK_REGISTRATION(ParseDocument);
+BENCHMARK_REGISTRATION(ParseStructural);
+BENCHMARK_REGISTRATION(ParseBorrowed);
+BENCHMARK_REGISTRATION(ParseInsitu);
+BENCHMARK_REGISTRATION(ParseLazy);
+BENCHMARK_REGISTRATION(ParseHandler);
+BENCHMARK_REGISTRATION(ParseStrings);
+BENCHMARK_REGISTRATION(ParseStringsStructural);
+BENCHMARK_REGISTRATION(ParseFloats);
+BENCHMARK_REGISTRATION(ParseIntegers);
+BENCHMARK_REGISTRATION(ParseNdjsonOne);
+BENCHMARK_REGISTRATION(ParseNdjsonAll);
+BENCHMARK_REGISTRATION(ParseNdjsonCopiedKeys);
+BENCHMARK_REGISTRATION(ParseNdjsonInternedKeys);
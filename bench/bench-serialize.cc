@@ -0,0 +1,62 @@
+#include <sstream>
+
+#include <jsoncc.h>
+#include "bench.h"
+
+namespace {
+
+// an array of size records, each a small nested object
+Json::Value make_document(size_t size)
+{
+	Json::Array doc;
+	for (size_t i(0); i < size; ++i) {
+		doc << Json::Object{
+			{"id", uint64_t(i)},
+			{"name", "some moderately long string value"},
+			{"ratio", 0.5},
+			{"enabled", true},
+			{"tags", Json::Array{"alpha", "beta", "gamma"}},
+			{"nested", Json::Object{{"key", "value"}, {"other", Json::Null()}}},
+		};
+	}
+	return Json::Value(std::move(doc));
+}
+
+class Serialize : public bench::Benchmark {
+public:
+	Serialize(const char *name, std::ios_base & (*format)(std::ios_base &))
+	:
+		bench::Benchmark(name),
+		format_(format)
+	{ }
+
+	void setup(size_t size) override
+	{
+		doc_ = make_document(size);
+	}
+
+	void run() override
+	{
+		std::ostringstream os;
+		os << format_ << doc_;
+	}
+
+private:
+	std::ios_base & (*format_)(std::ios_base &);
+	Json::Value doc_;
+};
+
+class SerializeIndent : public Serialize {
+public:
+	SerializeIndent() : Serialize("serialize indent", Json::indent) { }
+};
+
+class SerializeNoIndent : public Serialize {
+public:
+	SerializeNoIndent() : Serialize("serialize noindent", Json::noindent) { }
+};
+
+}
+
+BENCHMARK_REGISTRATION(SerializeIndent);
+BENCHMARK_REGISTRATION(SerializeNoIndent);
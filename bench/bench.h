@@ -0,0 +1,34 @@
+#ifndef JSONCC_BENCH_H
+#define JSONCC_BENCH_H
+
+#include <cstddef>
+#include <vector>
+
+namespace bench {
+
+/*
+ * A benchmark is run for a series of growing problem sizes.
+ * setup() prepares the input for a given size and is not timed,
+ * run() is the operation under test.
+ */
+class Benchmark {
+public:
+	explicit Benchmark(const char *name);
+	virtual ~Benchmark();
+
+	const char *name() const;
+
+	virtual void setup(size_t) = 0;
+	virtual void run() = 0;
+
+	static std::vector<Benchmark *> & registry();
+
+private:
+	const char *name_;
+};
+
+}
+
+#define BENCHMARK_REGISTRATION(type) static type type ## _instance
+
+#endif
@@ -0,0 +1,105 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <unistd.h>
+
+#include "bench.h"
+
+namespace bench {
+
+Benchmark::Benchmark(const char *name)
+:
+	name_(name)
+{
+	registry().push_back(this);
+}
+
+Benchmark::~Benchmark()
+{ }
+
+const char *Benchmark::name() const
+{
+	return name_;
+}
+
+std::vector<Benchmark *> & Benchmark::registry()
+{
+	static std::vector<Benchmark *> benchmarks;
+	return benchmarks;
+}
+
+}
+
+namespace {
+
+typedef std::chrono::steady_clock clock;
+
+// best of a few runs to filter out noise
+double measure(bench::Benchmark & b)
+{
+	double best(0);
+	for (int i(0); i < 5; ++i) {
+		auto start(clock::now());
+		b.run();
+		std::chrono::duration<double> elapsed(clock::now() - start);
+		if (i == 0 || elapsed.count() < best) {
+			best = elapsed.count();
+		}
+	}
+	return best;
+}
+
+void run(bench::Benchmark & b, size_t base, size_t steps)
+{
+	std::cout << b.name() << "\n";
+	double first(0);
+	for (size_t i(0); i < steps; ++i) {
+		size_t size(base << i);
+		b.setup(size);
+		double t(measure(b));
+		if (i == 0) {
+			first = t;
+		}
+		std::cout
+			<< "  size " << std::setw(10) << size
+			<< "  " << std::fixed << std::setprecision(6) << t << "s"
+			<< "  x" << std::setprecision(2) << (t / first)
+			<< "  " << std::setprecision(1) << (t * 1e9 / size) << " ns/unit\n";
+	}
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	size_t base(1000);
+	size_t steps(5);
+	const char *filter(nullptr);
+	int opt;
+	while ((opt = getopt(argc, argv, "b:s:t:")) != -1) {
+		switch (opt) {
+		case 'b':
+			base = strtoul(optarg, nullptr, 10);
+			break;
+		case 's':
+			steps = strtoul(optarg, nullptr, 10);
+			break;
+		case 't':
+			filter = optarg;
+			break;
+		default: /* '?' */
+			std::cerr << "Usage:" << argv[0] << " [-b base size] [-s steps] [-t name]\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	for (auto *b: bench::Benchmark::registry()) {
+		if (!filter || strstr(b->name(), filter)) {
+			run(*b, base, steps);
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -26,12 +26,16 @@
 #ifndef JSONCC_H
 #define JSONCC_H
 
+#include <atomic>
 #include <cstdint>
+#include <cstring>
+#include <functional>
 #include <list>
 #include <memory>
 #include <set>
 #include <sstream>
 #include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 namespace Json {
@@ -40,6 +44,14 @@ struct Null {};
 struct True {};
 struct False {};
 
+/*
+ * NOTE! Floating point values are stored as double,
+ * which is what rfc8259 suggests for interoperability.
+ * The long double interface is kept for compatibility,
+ * but long double values are rounded to double, and the
+ * parser rejects literals beyond the range of a double,
+ * e.g. 1e400, with NUMBER_INVALID.
+ */
 class Number {
 public:
 	enum Type {
@@ -50,8 +62,8 @@ public:
 	};
 
 	Number();
-	Number(Number const&);
-	Number(Number &&);
+	Number(Number const&) = default;
+	Number(Number &&) = default;
 	Number(uint8_t);
 	Number(int8_t);
 	Number(uint16_t);
@@ -64,8 +76,8 @@ public:
 	Number(double);
 	Number(long double);
 
-	Number & operator=(Number const&);
-	Number & operator=(Number &&);
+	Number & operator=(Number const&) = default;
+	Number & operator=(Number &&) = default;
 
 	Type type() const;
 	uint64_t uint_value() const;
@@ -78,33 +90,197 @@ private:
 	union {
 		uint64_t uint_;
 		int64_t int_;
-		long double float_;
+		double float_;
 	} value_;
 };
 
+/*
+ * Non owning reference to a sequence of chars, similar to
+ * std::string_view. It is only valid as long as the storage
+ * it was created from.
+ */
+class StringView {
+public:
+	StringView()
+	:
+		data_(""),
+		size_(0)
+	{ }
+
+	StringView(char const *data, size_t size)
+	:
+		data_(data),
+		size_(size)
+	{ }
+
+	StringView(char const *data)
+	:
+		data_(data),
+		size_(strlen(data))
+	{ }
+
+	StringView(std::string const& str)
+	:
+		data_(str.data()),
+		size_(str.size())
+	{ }
+
+	char const *data() const { return data_; }
+	size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+
+	char const *begin() const { return data_; }
+	char const *end() const { return data_ + size_; }
+
+	std::string str() const { return std::string(data_, size_); }
+
+private:
+	char const *data_;
+	size_t size_;
+};
+
+inline bool operator==(StringView const& l, StringView const& r)
+{
+	return l.size() == r.size() &&
+		(l.data() == r.data() || memcmp(l.data(), r.data(), l.size()) == 0);
+}
+
+inline bool operator!=(StringView const& l, StringView const& r)
+{
+	return !(l == r);
+}
+
+/*
+ * Non owning view of the elements of an Array or the members
+ * of an Object. It is invalidated by any modification of the
+ * container it was created from.
+ */
+template <typename T>
+class View {
+public:
+	typedef T const* const_iterator;
+
+	View(T const* first, size_t size)
+	:
+		first_(first),
+		size_(size)
+	{ }
+
+	const_iterator begin() const { return first_; }
+	const_iterator end() const { return first_ + size_; }
+	size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+	T const& operator[](size_t idx) const { return first_[idx]; }
+
+private:
+	T const* first_;
+	size_t size_;
+};
+
 class String {
 public:
 	String();
 	String(String const&);
 	String(String &&);
 	String(std::string const&);
+	String(std::string &&);
 	String(const char *);
 
 	String & operator=(String const&);
 	String & operator=(String &&);
 
 	std::string value() const;
+	std::string const& str() const;
 
 private:
 	std::string value_;
 };
 
+class Arena;
+
+void *arena_allocate(Arena *, size_t size, size_t align);
+void arena_deallocate(Arena *, void *);
+
+/*
+ * Allocator for the elements of Objects and Arrays.
+ * Without an Arena the global operator new is used.
+ * Memory taken from an Arena is only released when the
+ * Arena is, so it has to outlive every container using it.
+ */
+template <typename T>
+class Allocator {
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	Allocator()
+	:
+		arena_(nullptr)
+	{ }
+
+	explicit Allocator(Arena *arena)
+	:
+		arena_(arena)
+	{ }
+
+	template <typename U>
+	Allocator(Allocator<U> const& o)
+	:
+		arena_(o.arena())
+	{ }
+
+	T *allocate(size_t n)
+	{
+		return static_cast<T *>(arena_allocate(arena_, n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T *p, size_t)
+	{
+		arena_deallocate(arena_, p);
+	}
+
+	// copies never share the arena
+	Allocator select_on_container_copy_construction() const
+	{
+		return Allocator();
+	}
+
+	Arena *arena() const
+	{
+		return arena_;
+	}
+
+private:
+	Arena *arena_;
+};
+
+template <typename T, typename U>
+bool operator==(Allocator<T> const& l, Allocator<U> const& r)
+{
+	return l.arena() == r.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(Allocator<T> const& l, Allocator<U> const& r)
+{
+	return l.arena() != r.arena();
+}
+
 template<typename T> struct ValueFactory;
 
 class Member;
 class Object;
 class Array;
 
+/*
+ * Long strings, objects and arrays are shared by the
+ * copies of a Value, so copying one is O(1) and copies
+ * may be used by several threads. A Value is never
+ * modified in place. object() and array() return a copy
+ * of the container to be changed, which still shares the
+ * nested Values, and set() replaces the payload.
+ */
 class Value {
 public:
 	explicit operator bool() const
@@ -128,9 +304,11 @@ public:
 	template <typename T>
 	Value(T const& value)
 	:
-		tag_(TAG_INVALID)
+		payload_(),
+		tag_(TAG_INVALID),
+		storage_(STORAGE_LOCAL),
+		local_size_(0)
 	{
-		clear();
 		ValueFactory<T>::build(value, *this);
 	}
 
@@ -142,10 +320,14 @@ public:
 	Value(Object const&);
 	Value(Array const&);
 
+	Value(String &&);
+	Value(Object &&);
+	Value(Array &&);
+
 	Value(Value const&);
-	Value(Value&&);
+	Value(Value&&) noexcept;
 	Value & operator=(Value const&);
-	Value & operator=(Value&&);
+	Value & operator=(Value&&) noexcept;
 	~Value();
 
 	void set(Null const&);
@@ -156,6 +338,10 @@ public:
 	void set(Object const&);
 	void set(Array const&);
 
+	void set(String &&);
+	void set(Object &&);
+	void set(Array &&);
+
 	template <typename T, typename... Args>
 	void make(Args&&... args)
 	{
@@ -175,7 +361,26 @@ public:
 	Object object() const;
 	Array array() const;
 
+	/*
+	 * Like the accessors above but without copying the
+	 * payload. The results are only valid as long as the
+	 * value is neither modified nor destroyed.
+	 */
+	StringView as_string() const;
+	Object const& as_object() const;
+	Array const& as_array() const;
+
 private:
+	friend class ParserImpl;
+
+	// only for the parser, see Document
+	Value(StringView, Arena *);
+	Value(Object &&, Arena &);
+	Value(Array &&, Arena &);
+	static Value borrow(StringView);
+	// takes over a reference to a key of a KeyTable
+	static Value interned(StringView);
+
 	void build(std::unique_ptr<Number>);
 	void build(std::unique_ptr<String>);
 	void build(std::unique_ptr<Object>);
@@ -183,43 +388,87 @@ private:
 
 	void clone(Value const&);
 	void clear();
+	void assign(StringView, Arena * = nullptr);
+
+	/*
+	 * Numbers and strings of up to sizeof(Payload) chars are
+	 * stored in place, everything else on the heap or in the
+	 * Arena of a Document. Heap storage is reference counted
+	 * and released with the last copy. Arena storage is never
+	 * released by the Value itself, neither are borrowed
+	 * strings which point into the input of
+	 * Parser::parse_borrowed() or Parser::parse_insitu().
+	 * Interned strings are shared with a KeyTable and counted.
+	 */
+	union Payload {
+		Payload() : object(nullptr) { }
+
+		Number number;
+		char local[16];
+		struct {
+			char *data;
+			size_t size;
+		} heap;
+		Object *object;
+		Array *array;
+	};
 
-	Tag tag_;
+	enum Storage {
+		STORAGE_LOCAL,
+		STORAGE_HEAP,
+		STORAGE_ARENA,
+		STORAGE_BORROWED,
+		STORAGE_INTERNED,
+	};
 
-	std::unique_ptr<Number> number_;
-	std::unique_ptr<String> string_;
-	std::unique_ptr<Object> object_;
-	std::unique_ptr<Array> array_;
+	Payload payload_;
+	Tag tag_;
+	uint8_t storage_;
+	uint8_t local_size_;
 };
 
 class Member {
 public:
 	Member();
 	Member(Member const&);
-	Member(Member &&);
+	Member(Member &&) noexcept;
 	Member(std::string const&, Value const&);
 	Member(std::string &&, Value &&);
 
 	Member & operator=(Member const&);
-	Member & operator=(Member &&);
+	Member & operator=(Member &&) noexcept;
 
 	String key() const;
 	Value value() const;
 
+	StringView as_key() const;
+	Value const& as_value() const;
+
 private:
-	String key_;
+	friend class ParserImpl;
+
+	// key and value are owned by the Arena, if there is one
+	Member(Value &&, Value &&, Arena *);
+
+	Value key_;
 	Value value_;
 };
 
+class ObjectIndex;
+
 class Object {
 public:
+	typedef std::vector<Member, Allocator<Member> >::const_iterator const_iterator;
+
 	Object();
+	explicit Object(Allocator<Member> const&);
 	explicit Object(std::initializer_list<Member> l);
 	Object(Object const&);
-	Object(Object &&);
+	Object(Object &&) noexcept;
+	~Object();
 
 	Object & operator=(Object const&);
-	Object & operator=(Object &&);
+	Object & operator=(Object &&) noexcept;
 	Object & operator<<(Member const&);
 	Object & operator<<(Member &&);
 
@@ -227,40 +476,71 @@ public:
 	std::vector<Member> members() const;
 	Value member(std::string const&) const;
 
-	std::vector<Member>::const_iterator begin() const;
-	std::vector<Member>::const_iterator end() const;
+	View<Member> as_members() const;
+	/*
+	 * Returns the first member with the key or an invalid
+	 * Value if there is none. Objects with index_threshold
+	 * or more members build a hash index on the first
+	 * lookup, the members keep their order.
+	 */
+	Value const& as_member(StringView) const;
+
+	const_iterator begin() const;
+	const_iterator end() const;
+
+	static const size_t index_threshold = 16;
 
 private:
-	std::vector<Member> members_;
+	friend class ParserImpl;
+	friend class TreeHash;
+
+	ObjectIndex *index() const;
+	void index_last();
+	void drop_index();
+
+	std::vector<Member, Allocator<Member> > members_;
+	// built by the first lookup, uses the Allocator of members_
+	mutable std::atomic<ObjectIndex *> index_;
+	// see Json::hash(), 0 if unknown
+	mutable std::atomic<uint64_t> hash_;
 };
 
 class Array {
 public:
+	typedef std::vector<Value, Allocator<Value> >::const_iterator const_iterator;
+
 	Array();
+	explicit Array(Allocator<Value> const&);
 	explicit Array(std::initializer_list<Value>);
 	Array(Array const&);
-	Array(Array &&);
+	Array(Array &&) noexcept;
 
 	template <typename InputIterator>
 	Array(InputIterator first, InputIterator last)
 	:
-		elements_(first, last)
+		elements_(first, last),
+		hash_(0)
 	{ }
 
 	Array & operator=(Array const&);
-	Array & operator=(Array &&);
+	Array & operator=(Array &&) noexcept;
 	Array & operator<<(Value const&);
 	Array & operator<<(Value &&);
 	Array & operator<<(Member) = delete;
 
 	size_t size() const;
 	std::vector<Value> elements() const;
+	View<Value> as_elements() const;
 
-	std::vector<Value>::const_iterator begin() const;
-	std::vector<Value>::const_iterator end() const;
+	const_iterator begin() const;
+	const_iterator end() const;
 
 private:
-	std::vector<Value> elements_;
+	friend class TreeHash;
+
+	std::vector<Value, Allocator<Value> > elements_;
+	// see Json::hash(), 0 if unknown
+	mutable std::atomic<uint64_t> hash_;
 };
 
 template<> struct ValueFactory<bool>        { static void build(bool        const&, Value &); };
@@ -302,7 +582,7 @@ template<typename T> struct ValueFactory {
 	{
 		std::stringstream ss;
 		operator<<(ss, v);
-		res.make<String>(ss.str());
+		res.set(String(ss.str()));
 	}
 };
 
@@ -363,6 +643,8 @@ bool equal(Json::Array const&, Json::Array const&);
  * pair (member) in object A has a corresponting key value
  * pair in B.
  * NOTE! This implementaion allows duplicate keys.
+ * Members out of order are matched up by sorting them
+ * by key, so the comparison takes O(n log n).
  *
  * rfc8259 "An object is an unordered collection of zero or more name/value
  * pairs, ..." ... "The names within an object SHOULD be unique."
@@ -371,6 +653,32 @@ bool equal(Json::Object const&, Json::Object const&);
 /* Values are compared after unboxing using the rules above */
 bool equal(Json::Value const&, Json::Value const&);
 
+/*
+ * Hash of a Value consistent with equal(), equal Values
+ * have the same hash. The members of an object are hashed
+ * in any order. With cache set, the hashes of objects and
+ * arrays are kept in them for later calls, and equal()
+ * tells containers with different hashes apart without
+ * comparing them. Changing a container drops its hash.
+ * Not meant to withstand chosen input.
+ */
+size_t hash(Json::Value const&, bool cache = false);
+
+// for unordered containers of Values
+struct ValueHash {
+	size_t operator()(Json::Value const& value) const
+	{
+		return hash(value);
+	}
+};
+
+struct ValueEqual {
+	bool operator()(Json::Value const& l, Json::Value const& r) const
+	{
+		return equal(l, r);
+	}
+};
+
 struct Location {
 	size_t offs;
 	size_t character;
@@ -411,6 +719,7 @@ public:
 		BAD_TOKEN_OBJECT_VALUE, /* expected ',' or '}' after object member */
 		BAD_TOKEN_OBJECT_NEXT,  /* object contains bad member */
 		EMPTY_NAME,             /* the name of the member is empty */
+		UNEXPECTED_EVENT,       /* Reader or LazyValue found a different value than requested */
 		INTERNAL_ERROR,         /* internal error */
 	} type;
 
@@ -419,6 +728,255 @@ public:
 	Error(Type = OK, Location = Location());
 };
 
+class KeyTableImpl;
+
+/*
+ * Result of a parse where all nodes are allocated from
+ * one Arena owned by the Document. The whole tree is
+ * released in one step with the Document, or when it is
+ * parsed into again. The latter reuses the memory of
+ * the previous parse.
+ *
+ * The tree can not be modified, copying a Value out of
+ * it yields an independent, heap allocated Value. Further
+ * copies of that Value share its payload.
+ */
+class Document {
+public:
+	Document();
+	Document(Document &&);
+	Document & operator=(Document &&);
+	~Document();
+
+	Value const& root() const;
+
+	// bytes currently held by the arena
+	size_t capacity() const;
+
+private:
+	friend class ParserImpl;
+
+	Document(Document const&) = delete;
+	Document & operator=(Document const&) = delete;
+
+	std::unique_ptr<Arena> arena_;
+	// keeps interned keys alive, the tree does not count them
+	std::shared_ptr<KeyTableImpl> keys_;
+	Value root_;
+};
+
+class LazyDocumentImpl;
+
+/*
+ * A value in a LazyDocument, read from the input on access.
+ * Looking up a missing member or element, or one in a value
+ * of another type, gives an invalid LazyValue. The getters
+ * throw Error::UNEXPECTED_EVENT if the value has another
+ * type or is invalid. A LazyValue is only valid as long as
+ * the LazyDocument and its input are.
+ */
+class LazyValue {
+public:
+	LazyValue();
+
+	explicit operator bool() const
+	{
+		return doc_ != nullptr;
+	}
+
+	// the first member with this key
+	LazyValue operator[](StringView) const;
+	LazyValue operator[](size_t) const;
+
+	Value::Tag tag() const;
+
+	bool is_null() const;
+	bool get_bool() const;
+	int64_t get_int64() const;
+	double get_double() const;
+	std::string get_string() const;
+
+	// builds the value and everything below it
+	Value value() const;
+
+private:
+	friend class LazyDocument;
+
+	LazyValue(LazyDocumentImpl const*, size_t, size_t);
+
+	LazyDocumentImpl const *doc_;
+	size_t offs_;
+	size_t span_;
+};
+
+/*
+ * Result of a parse which only validates the input and
+ * records where each array and object ends. Values are
+ * read from the input when they are accessed, skipping
+ * over containers which are not. This pays off when only
+ * a few values of a large document are used.
+ *
+ * The input is not copied, it has to outlive the
+ * LazyDocument and must not be modified. Parsing into a
+ * LazyDocument again reuses its index.
+ */
+class LazyDocument {
+public:
+	LazyDocument();
+	LazyDocument(LazyDocument &&);
+	LazyDocument & operator=(LazyDocument &&);
+	~LazyDocument();
+
+	// invalid for an empty document
+	LazyValue root() const;
+
+	LazyValue operator[](StringView) const;
+	LazyValue operator[](size_t) const;
+
+private:
+	friend class ParserImpl;
+
+	LazyDocument(LazyDocument const&) = delete;
+	LazyDocument & operator=(LazyDocument const&) = delete;
+
+	std::unique_ptr<LazyDocumentImpl> impl_;
+};
+
+/*
+ * Receives a document from Parser::parse() in document
+ * order without building a tree. The StringViews are only
+ * valid during the call. Integers which do not fit into
+ * int64_t are rejected by the parser, so there is no
+ * unsigned callback. Exceptions thrown by a callback
+ * abort the parse and are passed on to the caller.
+ */
+class Handler {
+public:
+	virtual ~Handler();
+
+	virtual void null() = 0;
+	virtual void boolean(bool) = 0;
+	virtual void number(int64_t) = 0;
+	virtual void number(double) = 0;
+	virtual void string(StringView) = 0;
+
+	virtual void start_array() = 0;
+	virtual void end_array() = 0;
+
+	virtual void start_object() = 0;
+	virtual void key(StringView) = 0;
+	virtual void end_object() = 0;
+};
+
+class ReaderImpl;
+
+/*
+ * Pull parser for a single document. The events are
+ * taken one at a time with next(), the current value
+ * is available until the next call to next(), peek_type()
+ * or one of the read functions. The document is checked
+ * like by Parser, any error throws a Json::Error and leaves
+ * the Reader unusable. The input has to outlive the Reader.
+ */
+class Reader {
+public:
+	enum Event {
+		END,          /* end of the document */
+		NULL_VALUE,
+		BOOLEAN,
+		INT,
+		FLOAT,
+		STRING,
+		START_ARRAY,
+		END_ARRAY,
+		START_OBJECT,
+		KEY,
+		END_OBJECT,
+	};
+
+	Reader(char const *, size_t);
+	~Reader();
+
+	// see Parser::set_max_depth()
+	void set_max_depth(size_t);
+	size_t max_depth() const;
+
+	Event next();
+	// the event returned by the next call to next()
+	Event peek_type();
+
+	Event event() const;
+	// number of open arrays and objects
+	size_t depth() const;
+
+	// value of the current event
+	bool boolean() const;
+	int64_t int_value() const;
+	double float_value() const;
+	StringView string() const;
+
+	/*
+	 * Consume the next value and check its type, these
+	 * throw Error::UNEXPECTED_EVENT on a mismatch.
+	 * read_double() accepts integers.
+	 */
+	void read_null();
+	bool read_bool();
+	int64_t read_int();
+	double read_double();
+	std::string read_string();
+
+	void enter_array();
+	void enter_object();
+
+	// false at the end of the array which is then left
+	bool next_element();
+	// false at the end of the object which is then left,
+	// otherwise the key is in string()
+	bool next_key();
+
+	// consume the next value including nested containers
+	void skip_value();
+
+private:
+	Reader(Reader const&) = delete;
+	Reader & operator=(Reader const&) = delete;
+
+	void expect(Event);
+
+	std::unique_ptr<ReaderImpl> impl_;
+};
+
+/*
+ * Table of object keys shared by parsers, also across
+ * threads. A parser using a table stores each key only
+ * once in it, instead of once per member, and keys of
+ * different documents compare equal by their address.
+ * Copies of a KeyTable refer to the same table. Keys are
+ * never removed, they are released with the last copy
+ * of the table and the last Value referring to them.
+ */
+class KeyTable {
+public:
+	KeyTable();
+
+	// number of different keys
+	size_t size() const;
+
+	struct Stats {
+		Stats() : hits(0), misses(0) { }
+
+		size_t hits;   // found in the table
+		size_t misses; // added to the table
+	};
+
+private:
+	friend class Parser;
+	friend class NdjsonParser;
+
+	std::shared_ptr<KeyTableImpl> impl_;
+};
+
 class ParserImpl;
 
 class Parser {
@@ -431,6 +989,91 @@ public:
 
 	// does not throw
 	Value parse(char const *, size_t, Error &);
+
+	// throws Json::Error, the Document is cleared on error
+	void parse(char const *, size_t, Document &);
+
+	// does not throw, the Document is cleared on error
+	void parse(char const *, size_t, Document &, Error &);
+
+	/*
+	 * Like parse() into a Document, but strings and keys
+	 * without escape sequences are not copied. They refer
+	 * to the input, which must neither be modified nor
+	 * released while the Document holds the tree. Copies
+	 * of Values taken out of the Document are independent
+	 * of the input. Throws Json::Error.
+	 */
+	void parse_borrowed(char const *, size_t, Document &);
+
+	/*
+	 * Like parse_borrowed(), but escaped strings are decoded
+	 * in place as well, so no string is copied. Each string
+	 * is followed by a zero byte in the buffer. The contents
+	 * of the buffer are undefined afterwards, also if the
+	 * parse fails. Throws Json::Error.
+	 */
+	void parse_insitu(char *, size_t, Document &);
+
+	// throws Json::Error, the LazyDocument is cleared on error
+	void parse(char const *, size_t, LazyDocument &);
+
+	// throws Json::Error, the Handler may have seen a part of the document
+	void parse(char const *, size_t, Handler &);
+
+	// does not throw, the Handler may have seen a part of the document
+	void parse(char const *, size_t, Handler &, Error &);
+
+	/*
+	 * Parse a file mapped into memory, without a copy of its
+	 * contents. These throw Json::Error for the document and
+	 * std::system_error if the file can not be mapped.
+	 */
+	Value parse_file(std::string const&);
+	void parse_file(std::string const&, Document &);
+	void parse_file(std::string const&, Handler &);
+
+	/*
+	 * Maximum nesting depth of arrays and objects, deeper
+	 * documents fail with Error::PARSER_OVERFLOW. The parser
+	 * does not recurse, so the limit is independent of the
+	 * size of the thread stack. The default is 255.
+	 */
+	void set_max_depth(size_t);
+	size_t max_depth() const;
+
+	/*
+	 * How a Value or Document tree is parsed. Both backends
+	 * give the same trees and errors. STRUCTURAL_INDEX first
+	 * finds all tokens of the input in blocks of 64 bytes,
+	 * which pays off for documents with lots of whitespace,
+	 * like pretty printed ones. An invalid document is
+	 * parsed a second time by TOKEN_STREAM to locate the
+	 * error. In situ parsing, Handlers, LazyDocuments and
+	 * inputs of 2 GiB or more always use TOKEN_STREAM. The
+	 * default is TOKEN_STREAM.
+	 */
+	enum Backend {
+		TOKEN_STREAM,
+		STRUCTURAL_INDEX,
+	};
+
+	void set_backend(Backend);
+	Backend backend() const;
+
+	/*
+	 * Intern the object keys of Value and Document trees
+	 * in the table, or stop doing so with a null pointer.
+	 * The parser keeps its own reference to the table.
+	 * Keys short enough to be stored in place in a Value
+	 * are not interned, neither are the keys of borrowed
+	 * and in situ parses which are not copied anyway.
+	 */
+	void set_key_table(KeyTable const*);
+
+	// lookups in the table since it was set
+	KeyTable::Stats key_stats() const;
+
 private:
 	Parser(Parser const&) = delete;
 	Parser & operator=(Parser const&) = delete;
@@ -438,6 +1081,104 @@ private:
 	std::unique_ptr<ParserImpl> impl_;
 };
 
+class StreamParserImpl;
+
+/*
+ * Parser for a sequence of documents arriving in chunks,
+ * like from a socket. A chunk may end anywhere, also
+ * inside a string, number or utf8 sequence. Each chunk is
+ * parsed as it is fed, only the open containers and a
+ * partial string or number are kept until the next one.
+ * Errors are thrown by the feed() that has the first bad
+ * byte, at its offset in the whole stream.
+ */
+class StreamParser {
+public:
+	StreamParser();
+	~StreamParser();
+
+	// see Parser::set_max_depth()
+	void set_max_depth(size_t);
+	size_t max_depth() const;
+
+	/*
+	 * Both throw Json::Error and leave the StreamParser
+	 * unusable on errors, including an incomplete last
+	 * document in finish().
+	 */
+	void feed(char const *, size_t);
+	void finish();
+
+	// takes the oldest complete document, false if there is none
+	bool next(Value &);
+
+	// chars of a string or number split between chunks
+	size_t buffered() const;
+
+private:
+	StreamParser(StreamParser const&) = delete;
+	StreamParser & operator=(StreamParser const&) = delete;
+
+	std::unique_ptr<StreamParserImpl> impl_;
+};
+
+/*
+ * Parser for newline delimited json, one document per
+ * line. The input is split into batches of lines which
+ * are parsed by a pool of threads, each with its own
+ * Parser. Lines containing only whitespace are skipped.
+ */
+class NdjsonParser {
+public:
+	enum Order {
+		ORDERED,   /* records are delivered in input order */
+		UNORDERED, /* records are delivered as soon as parsed */
+	};
+
+	/*
+	 * A failed line has an invalid value and the error,
+	 * error.location.line is the line number starting at 1,
+	 * error.location.offs the offset in the whole input.
+	 */
+	struct Record {
+		size_t line;
+		Value value;
+		Error error;
+	};
+
+	typedef std::function<void(Record &)> Callback;
+
+	// threads = 0 uses one thread per core
+	explicit NdjsonParser(size_t threads = 0, Order = ORDERED);
+
+	// see Parser::set_max_depth()
+	void set_max_depth(size_t);
+	size_t max_depth() const;
+
+	/*
+	 * The callback runs on the calling thread, one record
+	 * at a time. An exception thrown by the callback stops
+	 * the workers and is passed on.
+	 */
+	void parse(char const *, size_t, Callback const&);
+
+	// like above for a file mapped into memory, see Parser::parse_file()
+	void parse_file(std::string const&, Callback const&);
+
+	// see Parser::set_key_table(), the table is used by all threads
+	void set_key_table(KeyTable const*);
+
+	// lookups of all threads since the table was set
+	KeyTable::Stats key_stats() const;
+
+private:
+	size_t threads_;
+	Order order_;
+	size_t max_depth_;
+	std::shared_ptr<KeyTableImpl> keys_;
+	KeyTable::Stats key_stats_;
+};
+
 }
 
 #endif
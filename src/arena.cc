@@ -0,0 +1,133 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+
+#include <jsoncc.h>
+#include <cassert>
+#include <cstdint>
+#include <new>
+
+#include "arena.h"
+
+namespace {
+
+const size_t min_block_size = 64 * 1024;
+const size_t max_block_size = 4 * 1024 * 1024;
+
+}
+
+namespace Json {
+
+struct Arena::Block {
+	Block *next;
+	size_t size;
+
+	char *begin()
+	{
+		return reinterpret_cast<char *>(this + 1);
+	}
+
+	char *end()
+	{
+		return begin() + size;
+	}
+};
+
+Arena::Arena()
+:
+	head_(nullptr),
+	current_(nullptr),
+	pos_(nullptr),
+	end_(nullptr),
+	capacity_(0)
+{ }
+
+Arena::~Arena()
+{
+	while (head_) {
+		Block *next(head_->next);
+		::operator delete(head_);
+		head_ = next;
+	}
+}
+
+void *Arena::allocate(size_t size, size_t align)
+{
+	assert(align && !(align & (align - 1)));
+	assert(align <= alignof(Block));
+
+	for (;;) {
+		uintptr_t pos(reinterpret_cast<uintptr_t>(pos_));
+		size_t pad((align - (pos & (align - 1))) & (align - 1));
+		if (pos_ && size + pad <= static_cast<size_t>(end_ - pos_)) {
+			void *res(pos_ + pad);
+			pos_ += pad + size;
+			return res;
+		}
+
+		// reuse the blocks of a previous run before growing
+		Block *next(current_ ? current_->next : head_);
+		if (!next || next->size < size) {
+			next = add_block(size);
+		}
+		current_ = next;
+		pos_ = current_->begin();
+		end_ = current_->end();
+	}
+}
+
+/* insert a new block after the current one */
+Arena::Block *Arena::add_block(size_t size)
+{
+	size_t block_size(capacity_ < min_block_size ? min_block_size : capacity_);
+	if (block_size > max_block_size) {
+		block_size = max_block_size;
+	}
+	if (block_size < size) {
+		block_size = size;
+	}
+
+	Block *block(static_cast<Block *>(::operator new(sizeof(Block) + block_size)));
+	block->size = block_size;
+	if (current_) {
+		block->next = current_->next;
+		current_->next = block;
+	} else {
+		block->next = head_;
+		head_ = block;
+	}
+
+	capacity_ += block_size;
+	return block;
+}
+
+void Arena::reset()
+{
+	current_ = nullptr;
+	pos_ = nullptr;
+	end_ = nullptr;
+}
+
+size_t Arena::capacity() const
+{
+	return capacity_;
+}
+
+void *arena_allocate(Arena *arena, size_t size, size_t align)
+{
+	if (arena) {
+		return arena->allocate(size, align);
+	}
+	return ::operator new(size);
+}
+
+void arena_deallocate(Arena *arena, void *p)
+{
+	if (!arena) {
+		::operator delete(p);
+	}
+}
+
+}
@@ -0,0 +1,49 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <cstddef>
+
+namespace Json {
+
+/*
+ * Monotonic allocator backing a Document.
+ * Memory is handed out from a list of blocks by bumping
+ * a pointer and never given back individually. reset()
+ * makes all blocks available again without freeing them,
+ * so a reused Arena stops allocating once it has grown to
+ * the size of the largest document parsed into it.
+ */
+class Arena {
+public:
+	Arena();
+	~Arena();
+
+	void *allocate(size_t size, size_t align);
+	void reset();
+
+	size_t capacity() const;
+
+private:
+	Arena(Arena const&) = delete;
+	Arena & operator=(Arena const&) = delete;
+
+	struct Block;
+
+	Block *add_block(size_t size);
+
+	Block *head_;
+	Block *current_;
+	char *pos_;
+	char *end_;
+	size_t capacity_;
+};
+
+}
+
+#endif
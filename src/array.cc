@@ -10,36 +10,49 @@ namespace Json {
 
 Array::Array()
 :
-	elements_()
+	elements_(),
+	hash_(0)
+{ }
+
+Array::Array(Allocator<Value> const& allocator)
+:
+	elements_(allocator),
+	hash_(0)
 { }
 
 Array::Array(std::initializer_list<Value> l)
 :
-	elements_(l)
+	elements_(l),
+	hash_(0)
 { }
 
 Array::Array(Array const& o)
 :
-	elements_(o.elements_)
+	elements_(o.elements_),
+	hash_(o.hash_.load(std::memory_order_relaxed))
 { }
 
-Array::Array(Array && o)
+Array::Array(Array && o) noexcept
 :
-	elements_(std::move(o.elements_))
+	elements_(std::move(o.elements_)),
+	hash_(o.hash_.exchange(0, std::memory_order_relaxed))
 { }
 
 Array & Array::operator=(Array const& o)
 {
 	if (&o != this) {
 		elements_ = o.elements_;
+		hash_.store(o.hash_.load(std::memory_order_relaxed), std::memory_order_relaxed);
 	}
 	return *this;
 }
 
-Array & Array::operator=(Array && o)
+Array & Array::operator=(Array && o) noexcept
 {
 	if (&o != this) {
 		elements_ = std::move(o.elements_);
+		hash_.store(o.hash_.exchange(0, std::memory_order_relaxed),
+			std::memory_order_relaxed);
 	}
 	return *this;
 }
@@ -47,12 +60,14 @@ Array & Array::operator=(Array && o)
 Array & Array::operator<<(Value const& element)
 {
 	elements_.push_back(element);
+	hash_.store(0, std::memory_order_relaxed);
 	return *this;
 }
 
 Array & Array::operator<<(Value && element)
 {
 	elements_.push_back(std::move(element));
+	hash_.store(0, std::memory_order_relaxed);
 	return *this;
 }
 
@@ -63,15 +78,20 @@ size_t Array::size() const
 
 std::vector<Value> Array::elements() const
 {
-	return elements_;
+	return std::vector<Value>(elements_.begin(), elements_.end());
+}
+
+View<Value> Array::as_elements() const
+{
+	return View<Value>(elements_.data(), elements_.size());
 }
 
-std::vector<Value>::const_iterator Array::begin() const
+Array::const_iterator Array::begin() const
 {
 	return elements_.begin();
 }
 
-std::vector<Value>::const_iterator Array::end() const
+Array::const_iterator Array::end() const
 {
 	return elements_.end();
 }
@@ -0,0 +1,51 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+#include <jsoncc.h>
+
+#include "arena.h"
+#include "key-table.h"
+
+namespace Json {
+
+Document::Document()
+:
+	arena_(new Arena()),
+	keys_(),
+	root_()
+{ }
+
+Document::Document(Document && o)
+:
+	arena_(std::move(o.arena_)),
+	keys_(std::move(o.keys_)),
+	root_(std::move(o.root_))
+{ }
+
+Document & Document::operator=(Document && o)
+{
+	if (&o != this) {
+		// the root does not touch the arena on destruction
+		root_ = std::move(o.root_);
+		arena_ = std::move(o.arena_);
+		keys_ = std::move(o.keys_);
+	}
+	return *this;
+}
+
+Document::~Document()
+{ }
+
+Value const& Document::root() const
+{
+	return root_;
+}
+
+size_t Document::capacity() const
+{
+	return arena_ ? arena_->capacity() : 0;
+}
+
+}
@@ -5,8 +5,96 @@
 */
 
 #include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include <jsoncc.h>
 
+#include "hash.h"
+
+namespace {
+
+// both hashes known, see Json::hash()
+bool differ(uint64_t l, uint64_t r)
+{
+	return l && r && l != r;
+}
+
+// below, the members are compared pairwise
+const size_t sort_threshold = 16;
+
+typedef Json::Object::const_iterator Members;
+typedef std::vector<Json::Member const*> Sorted;
+
+bool key_less(Json::StringView l, Json::StringView r)
+{
+	int res(memcmp(l.data(), r.data(), std::min(l.size(), r.size())));
+	return res < 0 || (res == 0 && l.size() < r.size());
+}
+
+bool same_value(Json::Member const* l, Json::Member const* r)
+{
+	return Json::equal(l->as_value(), r->as_value());
+}
+
+Sorted sorted(Members first, Members last)
+{
+	Sorted res;
+	res.reserve(last - first);
+	for (; first != last; ++first) {
+		res.push_back(&*first);
+	}
+	std::sort(res.begin(), res.end(), [](Json::Member const* l, Json::Member const* r) {
+		return key_less(l->as_key(), r->as_key());
+	});
+	return res;
+}
+
+Sorted::const_iterator key_end(Sorted::const_iterator first, Sorted::const_iterator last)
+{
+	Json::StringView key((*first)->as_key());
+	return std::find_if(first + 1, last, [&key](Json::Member const* m) {
+		return m->as_key() != key;
+	});
+}
+
+/*
+ * With both sides ordered by key, the members with the
+ * same key are next to each other. Their number has to
+ * match and their values have to be a permutation of
+ * each other, like for equal(Object, Object).
+ */
+bool equal_sorted(Members l_first, Members l_last, Members r_first)
+{
+	Sorted l(sorted(l_first, l_last));
+	Sorted r(sorted(r_first, r_first + (l_last - l_first)));
+
+	auto li(l.cbegin());
+	auto ri(r.cbegin());
+	while (li != l.cend()) {
+		if ((*li)->as_key() != (*ri)->as_key()) {
+			return false;
+		}
+
+		auto l_end(key_end(li, l.cend()));
+		auto r_end(key_end(ri, r.cend()));
+		if (l_end - li != r_end - ri) {
+			return false;
+		}
+
+		if (l_end - li == 1 ? !same_value(*li, *ri) :
+				!std::is_permutation(li, l_end, ri, same_value)) {
+			return false;
+		}
+
+		li = l_end;
+		ri = r_end;
+	}
+	return true;
+}
+
+}
+
 namespace Json {
 
 bool equal(Null const&, Null const&)
@@ -59,7 +147,7 @@ bool equal(Array const& l, Array const& r)
 		return true;
 	}
 
-	if (l.size() != r.size()) {
+	if (l.size() != r.size() || differ(TreeHash::cached(l), TreeHash::cached(r))) {
 		return false;
 	}
 
@@ -69,7 +157,7 @@ bool equal(Array const& l, Array const& r)
 
 bool equal(Member const& l, Member const& r)
 {
-	return (&l == &r) || (equal(l.key(), r.key()) && equal(l.value(), r.value()));
+	return (&l == &r) || (l.as_key() == r.as_key() && equal(l.as_value(), r.as_value()));
 }
 
 bool equal(Object const& l, Object const& r)
@@ -78,12 +166,18 @@ bool equal(Object const& l, Object const& r)
 		return true;
 	}
 
-	if (l.size() != r.size()) {
+	if (l.size() != r.size() || differ(TreeHash::cached(l), TreeHash::cached(r))) {
 		return false;
 	}
 
-	return is_permutation(std::begin(l), std::end(l), std::begin(r),
+	// members in the same order are the common case
+	auto first(std::mismatch(std::begin(l), std::end(l), std::begin(r),
+			[](Member const& l, Member const& r) { return equal(l, r); }));
+	if (std::end(l) - first.first < ptrdiff_t(sort_threshold)) {
+		return is_permutation(first.first, std::end(l), first.second,
 			[](Member const& l, Member const& r) { return equal(l, r); });
+	}
+	return equal_sorted(first.first, std::end(l), first.second);
 }
 
 bool equal(Value const& l, Value const& r)
@@ -108,11 +202,11 @@ bool equal(Value const& l, Value const& r)
 	case Value::TAG_NUMBER:
 		return equal(l.number(), r.number());
 	case Value::TAG_STRING:
-		return equal(l.string(), r.string());
+		return l.as_string() == r.as_string();
 	case Value::TAG_OBJECT:
-		return equal(l.object(), r.object());
+		return equal(l.as_object(), r.as_object());
 	case Value::TAG_ARRAY:
-		return equal(l.array(), r.array());
+		return equal(l.as_array(), r.as_array());
 	}
 
 	return false;
@@ -32,6 +32,7 @@ static const char *error_message[] = {
 	"expected ',' or '}' after object member",
 	"object contains bad member",
 	"member name is empty",
+	"unexpected value in reader",
 	"internal error",
 };
 
@@ -0,0 +1,260 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <clocale>
+#include <cstring>
+#include <string>
+
+#include "float-parse.h"
+#include "power5-table.h"
+
+#if defined(__GLIBC__) || defined(__APPLE__) || defined(__FreeBSD__)
+#define JSONCC_STRTOD_L
+#endif
+
+#if defined(JSONCC_STRTOD_L) && !defined(__GLIBC__)
+#include <xlocale.h>
+#endif
+
+namespace {
+
+const int mantissa_bits = 52;
+const int max_digits = 19;
+
+// value of a number as w * 10^q
+struct Decimal {
+	uint64_t w;
+	int64_t q;
+	bool negative;
+	bool truncated; // more than max_digits significant digits
+};
+
+bool is_digit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+Decimal parse_decimal(const char *p, const char *end)
+{
+	Decimal res{0, 0, false, false};
+	if (*p == '-') {
+		res.negative = true;
+		++p;
+	}
+
+	int digits(0);
+	auto add_digit([&res, &digits](char c) {
+		if (digits < max_digits) {
+			if (digits || c != '0') {
+				res.w = res.w * 10 + (c - '0');
+				++digits;
+			}
+			return true;
+		}
+		res.truncated |= c != '0';
+		return false;
+	});
+
+	for (; p != end && is_digit(*p); ++p) {
+		if (!add_digit(*p)) {
+			++res.q;
+		}
+	}
+
+	if (p != end && *p == '.') {
+		for (++p; p != end && is_digit(*p); ++p) {
+			if (add_digit(*p)) {
+				--res.q;
+			}
+		}
+	}
+
+	if (p != end && (*p == 'e' || *p == 'E')) {
+		++p;
+		bool negative(*p == '-');
+		if (*p == '-' || *p == '+') {
+			++p;
+		}
+		int64_t exp(0);
+		for (; p != end && is_digit(*p); ++p) {
+			// saturate, anything beyond is zero or infinite anyway
+			if (exp < 100000) {
+				exp = exp * 10 + (*p - '0');
+			}
+		}
+		res.q += negative ? -exp : exp;
+	}
+
+	return res;
+}
+
+struct Product {
+	uint64_t high;
+	uint64_t low;
+};
+
+Product multiply(uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 r(static_cast<unsigned __int128>(a) * b);
+	return Product{static_cast<uint64_t>(r >> 64), static_cast<uint64_t>(r)};
+#else
+	uint64_t a_lo(a & 0xffffffff), a_hi(a >> 32);
+	uint64_t b_lo(b & 0xffffffff), b_hi(b >> 32);
+	uint64_t lo_lo(a_lo * b_lo), hi_lo(a_hi * b_lo);
+	uint64_t lo_hi(a_lo * b_hi), hi_hi(a_hi * b_hi);
+	uint64_t cross((lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi);
+	return Product{hi_hi + (hi_lo >> 32) + (cross >> 32), (cross << 32) | (lo_lo & 0xffffffff)};
+#endif
+}
+
+/*
+ * Eisel-Lemire: multiply the normalized w with the 128 bit
+ * approximation of 5^q and read the result from the high bits.
+ * Returns the biased binary exponent of the double, 0x7ff if it
+ * is infinite, and sets its mantissa without the implicit bit.
+ */
+int64_t eisel_lemire(uint64_t w, int64_t q, uint64_t & mantissa)
+{
+	if (w == 0 || q < Json::power5_min) {
+		mantissa = 0;
+		return 0;
+	}
+	if (q > Json::power5_max) {
+		mantissa = 0;
+		return 0x7ff;
+	}
+
+	int lz(__builtin_clzll(w));
+	w <<= lz;
+
+	auto const& power(Json::power5_table[q - Json::power5_min]);
+	const uint64_t precision_mask(~uint64_t(0) >> (mantissa_bits + 3));
+	Product product(multiply(w, power.high));
+	if ((product.high & precision_mask) == precision_mask) {
+		Product low(multiply(w, power.low));
+		product.low += low.high;
+		if (low.high > product.low) {
+			++product.high;
+		}
+	}
+
+	int upperbit(product.high >> 63);
+	mantissa = product.high >> (upperbit + 64 - mantissa_bits - 3);
+	// floor(log2(10^q)) + 63, biased
+	int64_t power2(((217706 * q) >> 16) + 63 + upperbit - lz + 1023);
+
+	if (power2 <= 0) {
+		// subnormal
+		if (-power2 + 1 >= 64) {
+			mantissa = 0;
+			return 0;
+		}
+		mantissa >>= -power2 + 1;
+		mantissa += mantissa & 1;
+		mantissa >>= 1;
+		return mantissa < (uint64_t(1) << mantissa_bits) ? 0 : 1;
+	}
+
+	// exactly halfway between two doubles, round to even
+	if (product.low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 &&
+	    (mantissa << (upperbit + 64 - mantissa_bits - 3)) == product.high) {
+		mantissa &= ~uint64_t(1);
+	}
+
+	mantissa += mantissa & 1;
+	mantissa >>= 1;
+	if (mantissa >= (uint64_t(2) << mantissa_bits)) {
+		mantissa = uint64_t(1) << mantissa_bits;
+		++power2;
+	}
+	mantissa &= ~(uint64_t(1) << mantissa_bits);
+
+	return power2 >= 0x7ff ? 0x7ff : power2;
+}
+
+double make_double(uint64_t mantissa, int64_t power2, bool negative)
+{
+	uint64_t bits(mantissa | (uint64_t(power2) << mantissa_bits));
+	if (power2 == 0x7ff) {
+		bits = uint64_t(0x7ff) << mantissa_bits;
+	}
+	if (negative) {
+		bits |= uint64_t(1) << 63;
+	}
+	double res;
+	memcpy(&res, &bits, sizeof(res));
+	return res;
+}
+
+// for the rare inputs with many significant digits
+#ifdef JSONCC_STRTOD_L
+double parse_slow(const char *begin, const char *end)
+{
+	static locale_t c_locale(newlocale(LC_ALL_MASK, "C", 0));
+	std::string str(begin, end);
+	return strtod_l(str.c_str(), nullptr, c_locale);
+}
+#else
+/*
+ * Without strtod_l use the decimal point of the current locale.
+ * This is not safe against setlocale() in another thread.
+ */
+double parse_slow(const char *begin, const char *end)
+{
+	std::string str(begin, end);
+	size_t dot(str.find('.'));
+	if (dot != std::string::npos) {
+		str.replace(dot, 1, localeconv()->decimal_point);
+	}
+	return strtod(str.c_str(), nullptr);
+}
+#endif
+
+}
+
+namespace Json {
+
+bool parse_double(const char *begin, const char *end, double & res)
+{
+	Decimal d(parse_decimal(begin, end));
+
+#if FLT_EVAL_METHOD == 0
+	// Clinger: both operands and the result are exact or correctly rounded
+	static const double exact_powers[] = {
+		1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+		1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+		1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+	if (!d.truncated && d.w <= (uint64_t(1) << 53) && d.q >= -22 && d.q <= 22) {
+		res = static_cast<double>(d.w);
+		res = d.q < 0 ? res / exact_powers[-d.q] : res * exact_powers[d.q];
+		res = d.negative ? -res : res;
+		return true;
+	}
+#endif
+
+	uint64_t mantissa;
+	int64_t power2(eisel_lemire(d.w, d.q, mantissa));
+	if (d.truncated) {
+		// the exact value lies between w and w + 1
+		uint64_t upper_mantissa;
+		int64_t upper_power2(eisel_lemire(d.w + 1, d.q, upper_mantissa));
+		if (upper_power2 != power2 || upper_mantissa != mantissa) {
+			res = parse_slow(begin, end);
+			return !std::isinf(res);
+		}
+	}
+
+	res = make_double(mantissa, power2, d.negative);
+	return power2 != 0x7ff;
+}
+
+}
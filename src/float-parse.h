@@ -0,0 +1,22 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+
+#ifndef JSON_FLOAT_PARSE_H
+#define JSON_FLOAT_PARSE_H
+
+namespace Json {
+
+/*
+ * Correctly rounded conversion of the valid JSON number in
+ * [begin, end) to double, independent of the current locale.
+ * Returns false if the value is too large for a double. Tiny
+ * values round to a subnormal or to zero, like with strtod.
+ */
+bool parse_double(const char *begin, const char *end, double &);
+
+}
+
+#endif
@@ -0,0 +1,151 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+
+#include <cassert>
+#include <cstring>
+
+#include <jsoncc.h>
+#include "hash.h"
+
+namespace {
+
+// per type, so that e.g. [] and {} differ
+const uint64_t seed_invalid = 0x8c6e1f3b5a7d9e24;
+const uint64_t seed_null    = 0x3f84d5b5b5470917;
+const uint64_t seed_true    = 0x6a09e667f3bcc908;
+const uint64_t seed_false   = 0xbb67ae8584caa73b;
+const uint64_t seed_int     = 0x3c6ef372fe94f82b;
+const uint64_t seed_uint    = 0xa54ff53a5f1d36f1;
+const uint64_t seed_fp      = 0x510e527fade682d1;
+const uint64_t seed_number  = 0x9b05688c2b3e6c1f;
+const uint64_t seed_string  = 0x1f83d9abfb41bd6b;
+const uint64_t seed_array   = 0x5be0cd19137e2179;
+const uint64_t seed_object  = 0xcbbb9d5dc1059ed8;
+
+uint64_t hash_value(Json::Value const&, bool);
+
+// 0 marks a container without a cached hash
+uint64_t nonzero(uint64_t hash)
+{
+	return hash ? hash : 1;
+}
+
+uint64_t hash_number(Json::Number const& number)
+{
+	switch (number.type()) {
+	case Json::Number::TYPE_INVALID:
+		return Json::hash_mix(seed_number);
+	case Json::Number::TYPE_INT:
+		return Json::hash_mix(seed_int ^ uint64_t(number.int_value()));
+	case Json::Number::TYPE_UINT:
+		return Json::hash_mix(seed_uint ^ number.uint_value());
+	case Json::Number::TYPE_FP: {
+		// 0.0 and -0.0 are equal
+		double value(number.fp_value());
+		uint64_t bits(0);
+		if (value != 0) {
+			memcpy(&bits, &value, sizeof(bits));
+		}
+		return Json::hash_mix(seed_fp ^ bits);
+	}
+	}
+	assert(false); // LCOV_EXCL_LINE
+	return 0;      // LCOV_EXCL_LINE
+}
+
+uint64_t hash_string(Json::StringView str)
+{
+	return Json::hash_bytes(str.data(), str.size()) ^ seed_string;
+}
+
+// elements in order
+uint64_t hash_array(Json::Array const& array, bool cache)
+{
+	uint64_t res(Json::TreeHash::cached(array));
+	if (res) {
+		return res;
+	}
+
+	res = seed_array ^ array.size();
+	for (auto const& element : array) {
+		res = (res ^ hash_value(element, cache)) * 0xff51afd7ed558ccd;
+		res ^= res >> 29;
+	}
+	res = nonzero(Json::hash_mix(res));
+
+	if (cache) {
+		Json::TreeHash::store(array, res);
+	}
+	return res;
+}
+
+// a sum of the member hashes does not depend on their order
+uint64_t hash_object(Json::Object const& object, bool cache)
+{
+	uint64_t res(Json::TreeHash::cached(object));
+	if (res) {
+		return res;
+	}
+
+	uint64_t sum(0);
+	for (auto const& member : object) {
+		uint64_t value(hash_value(member.as_value(), cache));
+		sum += Json::hash_mix(hash_string(member.as_key()) ^ (value * 0xd6e8feb86659fd93));
+	}
+	res = nonzero(Json::hash_mix(seed_object ^ sum ^ object.size()));
+
+	if (cache) {
+		Json::TreeHash::store(object, res);
+	}
+	return res;
+}
+
+uint64_t hash_value(Json::Value const& value, bool cache)
+{
+	switch (value.tag()) {
+	case Json::Value::TAG_INVALID: return seed_invalid;
+	case Json::Value::TAG_NULL:    return seed_null;
+	case Json::Value::TAG_TRUE:    return seed_true;
+	case Json::Value::TAG_FALSE:   return seed_false;
+	case Json::Value::TAG_NUMBER:  return hash_number(value.number());
+	case Json::Value::TAG_STRING:  return hash_string(value.as_string());
+	case Json::Value::TAG_OBJECT:  return hash_object(value.as_object(), cache);
+	case Json::Value::TAG_ARRAY:   return hash_array(value.as_array(), cache);
+	}
+	assert(false); // LCOV_EXCL_LINE
+	return 0;      // LCOV_EXCL_LINE
+}
+
+}
+
+namespace Json {
+
+size_t hash(Value const& value, bool cache)
+{
+	return hash_value(value, cache);
+}
+
+uint64_t TreeHash::cached(Object const& object)
+{
+	return object.hash_.load(std::memory_order_relaxed);
+}
+
+uint64_t TreeHash::cached(Array const& array)
+{
+	return array.hash_.load(std::memory_order_relaxed);
+}
+
+void TreeHash::store(Object const& object, uint64_t hash)
+{
+	object.hash_.store(hash, std::memory_order_relaxed);
+}
+
+void TreeHash::store(Array const& array, uint64_t hash)
+{
+	array.hash_.store(hash, std::memory_order_relaxed);
+}
+
+}
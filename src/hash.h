@@ -0,0 +1,79 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+
+#ifndef JSON_HASH_H
+#define JSON_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Json {
+
+inline uint64_t hash_mix(uint64_t x)
+{
+	x ^= x >> 32;
+	x *= 0xd6e8feb86659fd93;
+	x ^= x >> 32;
+	x *= 0xd6e8feb86659fd93;
+	x ^= x >> 32;
+	return x;
+}
+
+inline uint64_t hash_word(uint64_t h, const char *p)
+{
+	uint64_t w;
+	memcpy(&w, p, 8);
+	h = (h ^ w) * 0xff51afd7ed558ccd;
+	return h ^ (h >> 29);
+}
+
+/*
+ * Hash of a byte string, 8 bytes per multiplication.
+ * Long strings go through four independent lanes, so
+ * the multiplications of a 32 byte block overlap.
+ * Not meant to withstand chosen keys.
+ */
+inline uint64_t hash_bytes(const char *p, size_t size)
+{
+	uint64_t h(0x9e3779b97f4a7c15 ^ size);
+	if (size >= 32) {
+		uint64_t l0(h), l1(h ^ 0x243f6a8885a308d3), l2(h ^ 0x13198a2e03707344),
+			l3(h ^ 0xa4093822299f31d0);
+		for (; size >= 32; p += 32, size -= 32) {
+			l0 = hash_word(l0, p);
+			l1 = hash_word(l1, p + 8);
+			l2 = hash_word(l2, p + 16);
+			l3 = hash_word(l3, p + 24);
+		}
+		h = ((l0 * 0xd6e8feb86659fd93 + l1) * 0xd6e8feb86659fd93 + l2) *
+			0xd6e8feb86659fd93 + l3;
+	}
+
+	for (; size >= 8; p += 8, size -= 8) {
+		h = hash_word(h, p);
+	}
+
+	uint64_t w(0);
+	memcpy(&w, p, size);
+	return hash_mix(h ^ w);
+}
+
+class Object;
+class Array;
+
+// the hashes cached by Json::hash(), 0 if there is none
+class TreeHash {
+public:
+	static uint64_t cached(Object const&);
+	static uint64_t cached(Array const&);
+	static void store(Object const&, uint64_t);
+	static void store(Array const&, uint64_t);
+};
+
+}
+
+#endif
@@ -6,6 +6,7 @@
 
 #include <jsoncc.h>
 #include <cassert>
+#include <cstring>
 #include <iomanip>
 
 namespace {
@@ -17,6 +18,7 @@ public:
 
 protected:
 	int overflow(int) override;
+	std::streamsize xsputn(const char *, std::streamsize) override;
 
 private:
 	std::string indent_;
@@ -51,11 +53,40 @@ int indent::overflow(int ch)
 	return dest_->sputc(ch);
 }
 
+// same as overflow() but for whole lines at once
+std::streamsize indent::xsputn(const char *s, std::streamsize n)
+{
+	std::streamsize done(0);
+	while (done < n) {
+		auto *nl(static_cast<const char *>(memchr(s + done, '\n', n - done)));
+		std::streamsize len(nl ? nl - (s + done) + 1 : n - done);
+		if (line_start_ && s[done] != '\n') {
+			dest_->sputn(indent_.c_str(), indent_.size());
+		}
+		line_start_ = (nl != nullptr);
+		auto res(dest_->sputn(s + done, len));
+		done += res;
+		if (res != len) {
+			break;
+		}
+	}
+	return done;
+}
 
-std::ostream & quote(std::ostream & os, std::string const& in)
+std::ostream & quote(std::ostream & os, Json::StringView in)
 {
 	os << '"';
-	for (auto c: in) {
+	auto *run(in.begin());
+	for (auto *p(in.begin()); p != in.end(); ++p) {
+		auto c(*p);
+		if (c != '"' && c != '\\' && static_cast<unsigned char>(c) > 0x1f) {
+			continue;
+		}
+
+		// write out everything up to the char to escape in one go
+		os.write(run, p - run);
+		run = p + 1;
+
 		switch (c) {
 /*
    All Unicode characters may be placed within the quotation marks,
@@ -81,10 +112,9 @@ std::ostream & quote(std::ostream & os, std::string const& in)
 		ESCAPE(0x1e, "u001e"); ESCAPE(0x1f, "u001f");
 		ESCAPE(0x22, "\"");    ESCAPE(0x5c, "\\");
 #undef ESCAPE
-		default:
-			os << c;
 		}
 	}
+	os.write(run, in.end() - run);
 	return os << '"';
 }
 
@@ -100,8 +130,8 @@ std::ostream & container_indent(std::ostream & os, const char delim[3], C const&
 	os << delim[0] << "\n";
 	{
 		indent in(os);
-		std::string sep;
-		for (auto item: c) {
+		const char *sep("");
+		for (auto const& item: c) {
 			os << sep << item;
 			sep = ",\n";
 		}
@@ -113,8 +143,8 @@ template <typename C>
 std::ostream & container_noindent(std::ostream & os, const char delim[3], C const& c)
 {
 	os << delim[0];
-	std::string sep;
-	for (auto item: c) {
+	const char *sep("");
+	for (auto const& item: c) {
 		os << sep << item;
 		sep = ", ";
 	}
@@ -182,22 +212,22 @@ std::ostream & operator<<(std::ostream & os, Number const& number)
 
 std::ostream & operator<<(std::ostream & os, String const& string)
 {
-	return ::quote(os, string.value());
+	return ::quote(os, string.str());
 }
 
 std::ostream & operator<<(std::ostream & os, Array const& array)
 {
-	return stream_container(os, "[]", array.elements());
+	return stream_container(os, "[]", array.as_elements());
 }
 
 std::ostream & operator<<(std::ostream & os, Member const& member)
 {
-	return os << member.key() << ": " << member.value();
+	return ::quote(os, member.as_key()) << ": " << member.as_value();
 }
 
 std::ostream & operator<<(std::ostream & os, Object const& object)
 {
-	return stream_container(os, "{}", object.members());
+	return stream_container(os, "{}", object.as_members());
 }
 
 std::ostream & operator<<(std::ostream & os, Value const& value)
@@ -215,11 +245,11 @@ std::ostream & operator<<(std::ostream & os, Value const& value)
 	case Value::TAG_NUMBER:
 		return os << value.number();
 	case Value::TAG_STRING:
-		return os << value.string();
+		return ::quote(os, value.as_string());
 	case Value::TAG_OBJECT:
-		return os << value.object();
+		return os << value.as_object();
 	case Value::TAG_ARRAY:
-		return os << value.array();
+		return os << value.as_array();
 	}
 
 	return os;
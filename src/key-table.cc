@@ -0,0 +1,112 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#include "hash.h"
+#include "key-table.h"
+
+namespace Json {
+
+InternedKey *InternedKey::create(StringView str, uint64_t hash)
+{
+	char *mem(new char[sizeof(InternedKey) + str.size()]);
+	memcpy(mem + sizeof(InternedKey), str.data(), str.size());
+	return new (mem) InternedKey(str.size(), hash);
+}
+
+KeyTableImpl::KeyTableImpl()
+:
+	shards_()
+{ }
+
+KeyTableImpl::~KeyTableImpl()
+{
+	for (auto & shard : shards_) {
+		for (auto & entry : shard.keys) {
+			entry.second->release();
+		}
+	}
+}
+
+InternedKey *KeyTableImpl::intern(StringView str, uint64_t hash, bool & added)
+{
+	// the low bits select the cache slot of the interner
+	Shard & shard(shards_[(hash >> 32) % shard_count]);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto range(shard.keys.equal_range(hash));
+	for (auto it(range.first); it != range.second; ++it) {
+		if (it->second->view() == str) {
+			added = false;
+			return it->second;
+		}
+	}
+
+	InternedKey *key(InternedKey::create(str, hash));
+	shard.keys.emplace(hash, key);
+	added = true;
+	return key;
+}
+
+size_t KeyTableImpl::size() const
+{
+	size_t res(0);
+	for (auto & shard : shards_) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		res += shard.keys.size();
+	}
+	return res;
+}
+
+KeyTable::KeyTable()
+:
+	impl_(std::make_shared<KeyTableImpl>())
+{ }
+
+size_t KeyTable::size() const
+{
+	return impl_->size();
+}
+
+KeyInterner::KeyInterner()
+:
+	stats(),
+	cache_(),
+	table_()
+{ }
+
+void KeyInterner::set_table(std::shared_ptr<KeyTableImpl> const& table)
+{
+	// the cached keys may belong to the old table
+	std::fill(cache_, cache_ + cache_size, nullptr);
+	table_ = table;
+	stats = KeyTable::Stats();
+}
+
+std::shared_ptr<KeyTableImpl> const& KeyInterner::table() const
+{
+	return table_;
+}
+
+InternedKey *KeyInterner::intern(StringView str)
+{
+	uint64_t hash(hash_bytes(str.data(), str.size()));
+	InternedKey *& slot(cache_[hash % cache_size]);
+	if (slot && slot->hash() == hash && slot->view() == str) {
+		++stats.hits;
+		return slot;
+	}
+
+	bool added;
+	slot = table_->intern(str, hash, added);
+	++(added ? stats.misses : stats.hits);
+	return slot;
+}
+
+}
@@ -0,0 +1,124 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+
+#ifndef JSON_KEY_TABLE_H
+#define JSON_KEY_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <jsoncc.h>
+
+namespace Json {
+
+/*
+ * Shared, immutable copy of a key. The chars follow
+ * the header in the same allocation, so a Value only
+ * stores the pointer to them and finds the header
+ * again when it is copied or destroyed.
+ */
+class InternedKey {
+public:
+	static InternedKey *create(StringView, uint64_t);
+
+	static InternedKey *from(char const * data)
+	{
+		return reinterpret_cast<InternedKey *>(const_cast<char *>(data)) - 1;
+	}
+
+	void acquire()
+	{
+		refs_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void release()
+	{
+		if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			this->~InternedKey();
+			delete[] reinterpret_cast<char *>(this);
+		}
+	}
+
+	StringView view() const
+	{
+		return StringView(reinterpret_cast<char const *>(this + 1), size_);
+	}
+
+	uint64_t hash() const
+	{
+		return hash_;
+	}
+
+private:
+	InternedKey(size_t size, uint64_t hash)
+	:
+		refs_(1),
+		hash_(hash),
+		size_(size)
+	{ }
+
+	std::atomic<size_t> refs_;
+	uint64_t hash_;
+	size_t size_;
+};
+
+/*
+ * The table holds one reference to each key and never
+ * drops a key, so the keys live as long as the table.
+ * Lookups are spread over shards with a lock each.
+ */
+class KeyTableImpl {
+public:
+	KeyTableImpl();
+	~KeyTableImpl();
+
+	// the key is owned by the table, added tells if it is new
+	InternedKey *intern(StringView, uint64_t, bool & added);
+	size_t size() const;
+
+private:
+	KeyTableImpl(KeyTableImpl const&) = delete;
+	KeyTableImpl & operator=(KeyTableImpl const&) = delete;
+
+	static const size_t shard_count = 16;
+
+	struct Shard {
+		mutable std::mutex mutex;
+		std::unordered_multimap<uint64_t, InternedKey *> keys;
+	};
+
+	Shard shards_[shard_count];
+};
+
+/*
+ * Per parser front of a KeyTableImpl. Recently seen keys
+ * are found in a small cache without taking a lock.
+ */
+class KeyInterner {
+public:
+	KeyInterner();
+
+	void set_table(std::shared_ptr<KeyTableImpl> const&);
+	std::shared_ptr<KeyTableImpl> const& table() const;
+
+	// the key is owned by the table
+	InternedKey *intern(StringView);
+
+	KeyTable::Stats stats;
+
+private:
+	static const size_t cache_size = 256;
+
+	InternedKey *cache_[cache_size];
+	std::shared_ptr<KeyTableImpl> table_;
+};
+
+}
+
+#endif
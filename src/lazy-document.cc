@@ -0,0 +1,308 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+
+#include <cstring>
+
+#include "error.h"
+#include "lazy-document.h"
+#include "parser-impl.h"
+#include "token-stream.h"
+#include "utf8stream.h"
+
+namespace {
+
+// tokenize a single scalar of a validated document
+Json::Token scan(char const * data, size_t size)
+{
+	Json::Utf8Stream stream(data, size);
+	Json::TokenStream tokenizer(stream);
+	tokenizer.scan();
+	return std::move(tokenizer.token);
+}
+
+}
+
+namespace Json {
+
+/*
+ * The input has been validated by the parser, so the
+ * scanners below need no bounds or syntax checks.
+ */
+size_t LazyDocumentImpl::skip_ws(size_t offs) const
+{
+	while (offs < size) {
+		switch (data[offs]) {
+		case ' ': case '\t': case '\r': case '\n':
+			++offs;
+			break;
+		default:
+			return offs;
+		}
+	}
+	return offs;
+}
+
+// offs is at the opening quote
+size_t LazyDocumentImpl::string_end(size_t offs) const
+{
+	for (++offs; data[offs] != '"'; ++offs) {
+		if (data[offs] == '\\') {
+			++offs;
+		}
+	}
+	return offs + 1;
+}
+
+bool LazyDocumentImpl::key_equals(size_t begin, size_t end, StringView key) const
+{
+	StringView raw(data + begin + 1, end - begin - 2);
+	if (!memchr(raw.data(), '\\', raw.size())) {
+		return raw == key;
+	}
+	return StringView(scan(data + begin, end - begin).str_value) == key;
+}
+
+size_t LazyDocumentImpl::value_end(size_t offs, size_t & span) const
+{
+	switch (data[offs]) {
+	case '[': case '{':
+		offs = spans[span].end + 1;
+		span = spans[span].next;
+		return offs;
+	case '"':
+		return string_end(offs);
+	default:
+		break;
+	}
+
+	while (offs < size) {
+		switch (data[offs]) {
+		case ' ': case '\t': case '\r': case '\n':
+		case ',': case ']': case '}':
+			return offs;
+		default:
+			++offs;
+		}
+	}
+	return offs;
+}
+
+bool LazyDocumentImpl::member(StringView key, size_t & offs, size_t & span) const
+{
+	size_t pos(offs + 1);
+	size_t child(span + 1);
+	for (;;) {
+		pos = skip_ws(pos);
+		if (data[pos] == '}') {
+			return false;
+		}
+
+		size_t key_end(string_end(pos));
+		bool match(key_equals(pos, key_end, key));
+		pos = skip_ws(skip_ws(key_end) + 1);
+		if (match) {
+			offs = pos;
+			span = child;
+			return true;
+		}
+
+		pos = skip_ws(value_end(pos, child));
+		if (data[pos] == ',') {
+			++pos;
+		}
+	}
+}
+
+bool LazyDocumentImpl::element(size_t idx, size_t & offs, size_t & span) const
+{
+	size_t pos(offs + 1);
+	size_t child(span + 1);
+	for (size_t i(0);; ++i) {
+		pos = skip_ws(pos);
+		if (data[pos] == ']') {
+			return false;
+		}
+
+		if (i == idx) {
+			offs = pos;
+			span = child;
+			return true;
+		}
+
+		pos = skip_ws(value_end(pos, child));
+		if (data[pos] == ',') {
+			++pos;
+		}
+	}
+}
+
+LazyValue::LazyValue()
+:
+	doc_(nullptr),
+	offs_(0),
+	span_(0)
+{ }
+
+LazyValue::LazyValue(LazyDocumentImpl const* doc, size_t offs, size_t span)
+:
+	doc_(doc),
+	offs_(offs),
+	span_(span)
+{ }
+
+LazyValue LazyValue::operator[](StringView key) const
+{
+	size_t offs(offs_);
+	size_t span(span_);
+	if (tag() != Value::TAG_OBJECT || !doc_->member(key, offs, span)) {
+		return LazyValue();
+	}
+	return LazyValue(doc_, offs, span);
+}
+
+LazyValue LazyValue::operator[](size_t idx) const
+{
+	size_t offs(offs_);
+	size_t span(span_);
+	if (tag() != Value::TAG_ARRAY || !doc_->element(idx, offs, span)) {
+		return LazyValue();
+	}
+	return LazyValue(doc_, offs, span);
+}
+
+Value::Tag LazyValue::tag() const
+{
+	if (!doc_) {
+		return Value::TAG_INVALID;
+	}
+
+	switch (doc_->data[offs_]) {
+	case 'n': return Value::TAG_NULL;
+	case 't': return Value::TAG_TRUE;
+	case 'f': return Value::TAG_FALSE;
+	case '"': return Value::TAG_STRING;
+	case '[': return Value::TAG_ARRAY;
+	case '{': return Value::TAG_OBJECT;
+	default:  return Value::TAG_NUMBER;
+	}
+}
+
+bool LazyValue::is_null() const
+{
+	return tag() == Value::TAG_NULL;
+}
+
+bool LazyValue::get_bool() const
+{
+	switch (tag()) {
+	case Value::TAG_TRUE:  return true;
+	case Value::TAG_FALSE: return false;
+	default:               break;
+	}
+	JSONCC_THROW(UNEXPECTED_EVENT);
+}
+
+int64_t LazyValue::get_int64() const
+{
+	if (tag() == Value::TAG_NUMBER) {
+		size_t span(span_);
+		Token token(scan(doc_->data + offs_, doc_->value_end(offs_, span) - offs_));
+		if (token.number_type == Token::INT) {
+			return token.int_value;
+		}
+	}
+	JSONCC_THROW(UNEXPECTED_EVENT);
+}
+
+double LazyValue::get_double() const
+{
+	if (tag() != Value::TAG_NUMBER) {
+		JSONCC_THROW(UNEXPECTED_EVENT);
+	}
+
+	size_t span(span_);
+	Token token(scan(doc_->data + offs_, doc_->value_end(offs_, span) - offs_));
+	if (token.number_type == Token::FLOAT) {
+		return token.float_value;
+	}
+	return token.int_value;
+}
+
+std::string LazyValue::get_string() const
+{
+	if (tag() != Value::TAG_STRING) {
+		JSONCC_THROW(UNEXPECTED_EVENT);
+	}
+
+	size_t span(span_);
+	return scan(doc_->data + offs_, doc_->value_end(offs_, span) - offs_).str_value;
+}
+
+Value LazyValue::value() const
+{
+	switch (tag()) {
+	case Value::TAG_INVALID: JSONCC_THROW(UNEXPECTED_EVENT);
+	case Value::TAG_NULL:    return Null();
+	case Value::TAG_TRUE:    return True();
+	case Value::TAG_FALSE:   return False();
+	case Value::TAG_STRING:  return String(get_string());
+	case Value::TAG_NUMBER:  break;
+	case Value::TAG_ARRAY:
+	case Value::TAG_OBJECT: {
+		// a container is a document of its own
+		Span const& span(doc_->spans[span_]);
+		ParserImpl parser;
+		parser.set_max_depth(doc_->max_depth);
+		return parser.parse(doc_->data + span.begin, span.end + 1 - span.begin);
+	}
+	}
+
+	size_t span(span_);
+	Token token(scan(doc_->data + offs_, doc_->value_end(offs_, span) - offs_));
+	if (token.number_type == Token::FLOAT) {
+		return Number(token.float_value);
+	}
+	return Number(token.int_value);
+}
+
+LazyDocument::LazyDocument()
+:
+	impl_(new LazyDocumentImpl())
+{ }
+
+LazyDocument::LazyDocument(LazyDocument && o)
+:
+	impl_(std::move(o.impl_))
+{ }
+
+LazyDocument & LazyDocument::operator=(LazyDocument && o)
+{
+	impl_ = std::move(o.impl_);
+	return *this;
+}
+
+LazyDocument::~LazyDocument()
+{ }
+
+LazyValue LazyDocument::root() const
+{
+	if (!impl_ || impl_->spans.empty()) {
+		return LazyValue();
+	}
+	return LazyValue(impl_.get(), impl_->spans.front().begin, 0);
+}
+
+LazyValue LazyDocument::operator[](StringView key) const
+{
+	return root()[key];
+}
+
+LazyValue LazyDocument::operator[](size_t idx) const
+{
+	return root()[idx];
+}
+
+}
@@ -0,0 +1,66 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+#ifndef JSON_LAZY_DOCUMENT_H
+#define JSON_LAZY_DOCUMENT_H
+
+#include <vector>
+
+#include <jsoncc.h>
+
+namespace Json {
+
+// an array or object in the input, in document order
+struct Span {
+	size_t begin; // offset of the opening bracket
+	size_t end;   // offset of the closing bracket
+	size_t next;  // index of the first Span after this subtree
+};
+
+/*
+ * The index of a validated document. Navigation runs over
+ * the input and uses the spans to step over containers.
+ */
+class LazyDocumentImpl {
+public:
+	LazyDocumentImpl()
+	:
+		data(nullptr),
+		size(0),
+		max_depth(0),
+		spans(),
+		open()
+	{ }
+
+	void clear()
+	{
+		data = nullptr;
+		size = 0;
+		spans.clear();
+		open.clear();
+	}
+
+	// locate a member or element, span is that of the container on entry
+	bool member(StringView, size_t & offs, size_t & span) const;
+	bool element(size_t, size_t & offs, size_t & span) const;
+
+	// offset past the value at offs, advances span past its subtree
+	size_t value_end(size_t offs, size_t & span) const;
+
+	char const *data;
+	size_t size;
+	size_t max_depth;
+	std::vector<Span> spans;
+	std::vector<size_t> open; // spans of the open containers while parsing
+
+private:
+	size_t skip_ws(size_t) const;
+	size_t string_end(size_t) const;
+	bool key_equals(size_t, size_t, StringView) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,126 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped-file.h"
+
+namespace {
+
+void throw_errno(std::string const& what)
+{
+	throw std::system_error(errno, std::system_category(), what);
+}
+
+class FileDescriptor {
+public:
+	explicit FileDescriptor(std::string const& path)
+	:
+		fd_(::open(path.c_str(), O_RDONLY | O_CLOEXEC))
+	{
+		if (fd_ < 0) {
+			throw_errno("open " + path);
+		}
+	}
+
+	~FileDescriptor()
+	{
+		::close(fd_);
+	}
+
+	int get() const
+	{
+		return fd_;
+	}
+
+private:
+	int fd_;
+};
+
+}
+
+namespace Json {
+
+MappedFile::MappedFile(std::string const& path)
+:
+	data_(""),
+	size_(0),
+	mapped_(false),
+	buffer_()
+{
+	FileDescriptor fd(path);
+
+	struct stat st;
+	if (::fstat(fd.get(), &st) < 0) {
+		throw_errno("stat " + path);
+	}
+
+	// files in /proc report a size of 0 as well
+	if (!S_ISREG(st.st_mode)) {
+		read(fd.get(), path);
+		return;
+	}
+
+	// mmap() rejects empty mappings
+	if (st.st_size == 0) {
+		return;
+	}
+
+	size_t size(st.st_size);
+	void *data(::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.get(), 0));
+	if (data == MAP_FAILED) {
+		throw_errno("mmap " + path);
+	}
+
+	// only hints, failures are harmless
+	::madvise(data, size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+	::madvise(data, size, MADV_HUGEPAGE);
+#endif
+
+	data_ = static_cast<char const *>(data);
+	size_ = size;
+	mapped_ = true;
+}
+
+MappedFile::~MappedFile()
+{
+	if (mapped_) {
+		::munmap(const_cast<char *>(data_), size_);
+	}
+}
+
+void MappedFile::read(int fd, std::string const& path)
+{
+	const size_t chunk_size(64 * 1024);
+	for (;;) {
+		size_t size(buffer_.size());
+		buffer_.resize(size + chunk_size);
+		ssize_t res(::read(fd, &buffer_[size], chunk_size));
+		if (res < 0 && errno == EINTR) {
+			buffer_.resize(size);
+			continue;
+		}
+		if (res < 0) {
+			throw_errno("read " + path);
+		}
+		buffer_.resize(size + res);
+		if (res == 0) {
+			break;
+		}
+	}
+
+	data_ = buffer_.data();
+	size_ = buffer_.size();
+}
+
+}
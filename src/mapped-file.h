@@ -0,0 +1,49 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+#ifndef JSON_MAPPED_FILE_H
+#define JSON_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace Json {
+
+/*
+ * Read only mapping of a whole file, advised for a single
+ * sequential pass. Pipes, devices and the like are read
+ * into memory instead, their size is not known upfront.
+ * Throws std::system_error on failure.
+ */
+class MappedFile {
+public:
+	explicit MappedFile(std::string const&);
+	~MappedFile();
+
+	char const *data() const
+	{
+		return data_;
+	}
+
+	size_t size() const
+	{
+		return size_;
+	}
+
+private:
+	MappedFile(MappedFile const&) = delete;
+	MappedFile & operator=(MappedFile const&) = delete;
+
+	void read(int, std::string const&);
+
+	char const *data_;
+	size_t size_;
+	bool mapped_;
+	std::string buffer_;
+};
+
+}
+
+#endif
@@ -10,7 +10,7 @@ namespace Json {
 
 Member::Member()
 :
-	key_(),
+	key_(String()),
 	value_()
 { }
 
@@ -20,7 +20,7 @@ Member::Member(Member const& o)
 	value_(o.value_)
 { }
 
-Member::Member(Member && o)
+Member::Member(Member && o) noexcept
 :
 	key_(std::move(o.key_)),
 	value_(std::move(o.value_))
@@ -28,18 +28,26 @@ Member::Member(Member && o)
 
 Member::Member(std::string const& key, Value const& value)
 :
-	key_(key),
+	key_(String(key)),
 	value_(value)
 {
 	assert(!key.empty());
 }
 
 Member::Member(std::string && key, Value && value)
+:
+	key_(String(std::move(key))),
+	value_(std::move(value))
+{
+	assert(!key_.as_string().empty());
+}
+
+Member::Member(Value && key, Value && value, Arena *)
 :
 	key_(std::move(key)),
 	value_(std::move(value))
 {
-	assert(!key.empty());
+	assert(!key_.as_string().empty());
 }
 
 Member & Member::operator=(Member const& o)
@@ -51,7 +59,7 @@ Member & Member::operator=(Member const& o)
 	return *this;
 }
 
-Member & Member::operator=(Member && o)
+Member & Member::operator=(Member && o) noexcept
 {
 	if (&o != this) {
 		key_ = std::move(o.key_);
@@ -62,7 +70,7 @@ Member & Member::operator=(Member && o)
 
 String Member::key() const
 {
-	return key_;
+	return key_.string();
 }
 
 Value Member::value() const
@@ -70,4 +78,14 @@ Value Member::value() const
 	return value_;
 }
 
+StringView Member::as_key() const
+{
+	return key_.as_string();
+}
+
+Value const& Member::as_value() const
+{
+	return value_;
+}
+
 }
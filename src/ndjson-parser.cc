@@ -0,0 +1,328 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <jsoncc.h>
+#include "mapped-file.h"
+#include "parser-impl.h"
+
+namespace {
+
+// bytes per batch, a batch is extended to the end of its last line
+const size_t batch_size = 256 * 1024;
+
+// batches in flight per thread, limits the results held back
+const size_t batches_per_thread = 4;
+
+struct Batch {
+	Batch(char const * begin_, char const * end_)
+	:
+		begin(begin_),
+		end(end_),
+		lines(0),
+		counted(false),
+		records()
+	{ }
+
+	char const *begin;
+	char const *end;
+	size_t lines;
+	bool counted;
+	// line numbers and offsets relative to the batch
+	std::vector<Json::NdjsonParser::Record> records;
+};
+
+/*
+ * State shared by the workers and the delivering thread.
+ * Workers claim batches in input order, so the line
+ * count of every batch before a claimed one is known
+ * shortly after.
+ */
+struct Job {
+	Job(char const * data, size_t size, size_t window_, size_t max_depth_,
+			std::shared_ptr<Json::KeyTableImpl> const& keys_)
+	:
+		mutex(),
+		ready(),
+		work(),
+		batches(),
+		finished(),
+		next(0),
+		delivered(0),
+		window(window_),
+		max_depth(max_depth_),
+		keys(keys_),
+		key_stats(),
+		stop(false),
+		error()
+	{
+		char const *end(data + size);
+		while (data < end) {
+			char const *batch_end(end);
+			if (size_t(end - data) > batch_size) {
+				auto nl(static_cast<char const *>(
+					memchr(data + batch_size, '\n', end - data - batch_size)));
+				batch_end = nl ? nl + 1 : end;
+			}
+			batches.emplace_back(data, batch_end);
+			data = batch_end;
+		}
+	}
+
+	void run()
+	{
+		try {
+			Json::ParserImpl parser;
+			parser.set_max_depth(max_depth);
+			parser.set_key_table(keys);
+			for (;;) {
+				size_t k;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					work.wait(lock, [this] {
+						return stop || next >= batches.size() ||
+							next < delivered + window;
+					});
+					if (stop || next >= batches.size()) {
+						break;
+					}
+					k = next++;
+				}
+
+				Batch & batch(batches[k]);
+				size_t lines(std::count(batch.begin, batch.end, '\n'));
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					batch.lines = lines;
+					batch.counted = true;
+				}
+				ready.notify_all();
+
+				parse(parser, batch);
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					finished.push_back(k);
+				}
+				ready.notify_all();
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			key_stats.hits += parser.key_stats().hits;
+			key_stats.misses += parser.key_stats().misses;
+		} catch (...) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				error = std::current_exception();
+				stop = true;
+			}
+			ready.notify_all();
+			work.notify_all();
+		}
+	}
+
+	void parse(Json::ParserImpl & parser, Batch & batch)
+	{
+		size_t line(0);
+		char const *pos(batch.begin);
+		while (pos < batch.end) {
+			auto nl(static_cast<char const *>(memchr(pos, '\n', batch.end - pos)));
+			char const *line_end(nl ? nl : batch.end);
+
+			Json::NdjsonParser::Record record;
+			record.line = line++;
+			try {
+				record.value = parser.parse(pos, line_end - pos);
+			} catch (Json::Error & e) {
+				record.error = e;
+				record.error.location.offs += pos - batch.begin;
+			}
+
+			// blank lines give neither a value nor an error
+			if (record.value || record.error) {
+				batch.records.push_back(std::move(record));
+			}
+			pos = line_end + 1;
+		}
+	}
+
+	std::mutex mutex;
+	std::condition_variable ready; // for the delivering thread
+	std::condition_variable work;  // for the workers
+	std::vector<Batch> batches;
+	std::vector<size_t> finished;  // done but not delivered
+	size_t next;
+	size_t delivered;
+	size_t window;
+	size_t max_depth;
+	std::shared_ptr<Json::KeyTableImpl> keys;
+	Json::KeyTable::Stats key_stats;
+	bool stop;
+	std::exception_ptr error;
+};
+
+class Delivery {
+public:
+	Delivery(Job & job, char const * data, Json::NdjsonParser::Callback const& callback)
+	:
+		job_(job),
+		data_(data),
+		callback_(callback),
+		first_lines_(1, 0)
+	{ }
+
+	// wait for a batch which can be delivered, false when all are
+	bool wait(Json::NdjsonParser::Order order, size_t & k)
+	{
+		std::unique_lock<std::mutex> lock(job_.mutex);
+		job_.ready.wait(lock, [this, order, &k] {
+			return job_.error || job_.delivered == job_.batches.size() ||
+				select(order, k);
+		});
+
+		if (job_.error) {
+			std::rethrow_exception(job_.error);
+		}
+
+		return job_.delivered != job_.batches.size();
+	}
+
+	void deliver(size_t k)
+	{
+		Batch & batch(job_.batches[k]);
+		for (auto & record : batch.records) {
+			record.line += first_lines_[k] + 1;
+			if (record.error) {
+				record.error.location.line = record.line;
+				record.error.location.offs += batch.begin - data_;
+			}
+			callback_(record);
+		}
+		std::vector<Json::NdjsonParser::Record>().swap(batch.records);
+
+		{
+			std::lock_guard<std::mutex> lock(job_.mutex);
+			++job_.delivered;
+		}
+		job_.work.notify_all();
+	}
+
+private:
+	// called with the mutex held
+	bool select(Json::NdjsonParser::Order order, size_t & k)
+	{
+		while (first_lines_.size() <= job_.batches.size() &&
+				job_.batches[first_lines_.size() - 1].counted) {
+			first_lines_.push_back(first_lines_.back() +
+				job_.batches[first_lines_.size() - 1].lines);
+		}
+
+		auto & finished(job_.finished);
+		for (auto it(finished.begin()); it != finished.end(); ++it) {
+			if (order == Json::NdjsonParser::ORDERED && *it != job_.delivered) {
+				continue;
+			}
+
+			// the first line is only known once all batches before are counted
+			if (*it < first_lines_.size()) {
+				k = *it;
+				finished.erase(it);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	Job & job_;
+	char const *data_;
+	Json::NdjsonParser::Callback const& callback_;
+	// first line of each counted batch
+	std::vector<size_t> first_lines_;
+};
+
+}
+
+namespace Json {
+
+NdjsonParser::NdjsonParser(size_t threads, Order order)
+:
+	threads_(threads ? threads : std::max(1u, std::thread::hardware_concurrency())),
+	order_(order),
+	max_depth_(ParserImpl::DEFAULT_MAX_DEPTH),
+	keys_(),
+	key_stats_()
+{ }
+
+void NdjsonParser::set_max_depth(size_t depth)
+{
+	max_depth_ = depth;
+}
+
+size_t NdjsonParser::max_depth() const
+{
+	return max_depth_;
+}
+
+void NdjsonParser::set_key_table(KeyTable const* table)
+{
+	keys_ = table ? table->impl_ : nullptr;
+	key_stats_ = KeyTable::Stats();
+}
+
+KeyTable::Stats NdjsonParser::key_stats() const
+{
+	return key_stats_;
+}
+
+void NdjsonParser::parse(char const * data, size_t size, Callback const& callback)
+{
+	Job job(data, size, threads_ * batches_per_thread, max_depth_, keys_);
+
+	std::vector<std::thread> workers;
+	for (size_t i(0); i < std::min(threads_, job.batches.size()); ++i) {
+		workers.emplace_back(&Job::run, &job);
+	}
+
+	auto join([&job, &workers] {
+		{
+			std::lock_guard<std::mutex> lock(job.mutex);
+			job.stop = true;
+		}
+		job.work.notify_all();
+		for (auto & worker : workers) {
+			worker.join();
+		}
+	});
+
+	try {
+		Delivery delivery(job, data, callback);
+		size_t k(0);
+		while (delivery.wait(order_, k)) {
+			delivery.deliver(k);
+		}
+	} catch (...) {
+		join();
+		throw;
+	}
+	join();
+
+	key_stats_.hits += job.key_stats.hits;
+	key_stats_.misses += job.key_stats.misses;
+}
+
+void NdjsonParser::parse_file(std::string const& path, Callback const& callback)
+{
+	MappedFile file(path);
+	parse(file.data(), file.size(), callback);
+}
+
+}
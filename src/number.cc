@@ -14,18 +14,6 @@ Number::Number()
 	value_()
 { }
 
-Number::Number(Number const& o)
-:
-	type_(o.type_),
-	value_(o.value_)
-{ }
-
-Number::Number(Number && o)
-:
-	type_(std::move(o.type_)),
-	value_(std::move(o.value_))
-{ }
-
 Number::Number(uint8_t value)
 :
 	type_(TYPE_UINT),
@@ -111,25 +99,7 @@ Number::Number(long double value)
 	type_(TYPE_FP),
 	value_()
 {
-	value_.float_ = value;
-}
-
-Number & Number::operator=(Number const& o)
-{
-	if (&o != this) {
-		type_ = o.type_;
-		value_ = o.value_;
-	}
-	return *this;
-}
-
-Number & Number::operator=(Number && o)
-{
-	if (&o != this) {
-		type_ = std::move(o.type_);
-		value_ = std::move(o.value_);
-	}
-	return *this;
+	value_.float_ = static_cast<double>(value);
 }
 
 Number::Type Number::type() const
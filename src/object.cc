@@ -6,40 +6,166 @@
 #include <jsoncc.h>
 #include <algorithm>
 
+#include "hash.h"
+
 namespace Json {
 
+/*
+ * Open addressing table over the keys of an Object with
+ * linear probing, at most half of the slots are in use.
+ * A slot holds the position of a member plus one, zero
+ * marks an empty slot, and the low bits of the key hash.
+ * Only the first member with a key is entered, so lookups
+ * find the same member as a linear search.
+ */
+class ObjectIndex {
+public:
+	static ObjectIndex *create(Arena *arena, size_t size)
+	{
+		size_t capacity(32);
+		while (capacity < 2 * size) {
+			capacity *= 2;
+		}
+
+		size_t bytes(sizeof(ObjectIndex) + capacity * sizeof(Slot));
+		void *p(arena_allocate(arena, bytes, alignof(ObjectIndex)));
+		auto res(new (p) ObjectIndex(capacity));
+		memset(res->slots(), 0, capacity * sizeof(Slot));
+		return res;
+	}
+
+	static void destroy(Arena *arena, ObjectIndex *index)
+	{
+		if (index) {
+			arena_deallocate(arena, index);
+		}
+	}
+
+	// false if the table is full
+	bool insert(Member const *members, size_t pos)
+	{
+		if (2 * (used_ + 1) > mask_ + 1) {
+			return false;
+		}
+
+		StringView key(members[pos].as_key());
+		uint32_t hash(hash_bytes(key.data(), key.size()));
+		for (size_t i(hash & mask_);; i = (i + 1) & mask_) {
+			Slot & slot(slots()[i]);
+			if (slot.pos == 0) {
+				slot.pos = pos + 1;
+				slot.hash = hash;
+				++used_;
+				return true;
+			}
+
+			if (slot.hash == hash && members[slot.pos - 1].as_key() == key) {
+				return true;
+			}
+		}
+	}
+
+	Member const *find(Member const *members, StringView key) const
+	{
+		uint32_t hash(hash_bytes(key.data(), key.size()));
+		for (size_t i(hash & mask_);; i = (i + 1) & mask_) {
+			Slot const& slot(slots()[i]);
+			if (slot.pos == 0) {
+				return nullptr;
+			}
+
+			if (slot.hash == hash && members[slot.pos - 1].as_key() == key) {
+				return &members[slot.pos - 1];
+			}
+		}
+	}
+
+private:
+	struct Slot {
+		uint32_t pos;
+		uint32_t hash;
+	};
+
+	explicit ObjectIndex(size_t capacity)
+	:
+		mask_(capacity - 1),
+		used_(0)
+	{ }
+
+	Slot *slots()
+	{
+		return reinterpret_cast<Slot *>(this + 1);
+	}
+
+	Slot const *slots() const
+	{
+		return reinterpret_cast<Slot const *>(this + 1);
+	}
+
+	size_t mask_;
+	size_t used_;
+};
+
 Object::Object()
 :
-	members_()
+	members_(),
+	index_(nullptr),
+	hash_(0)
+{ }
+
+Object::Object(Allocator<Member> const& allocator)
+:
+	members_(allocator),
+	index_(nullptr),
+	hash_(0)
 { }
 
 Object::Object(std::initializer_list<Member> l)
 :
-	members_(l)
+	members_(l),
+	index_(nullptr),
+	hash_(0)
 { }
 
 Object::Object(Object const& o)
 :
-	members_(o.members_)
+	members_(o.members_),
+	index_(nullptr),
+	hash_(o.hash_.load(std::memory_order_relaxed))
 { }
 
-Object::Object(Object && o)
+Object::Object(Object && o) noexcept
 :
-	members_(std::move(o.members_))
+	members_(std::move(o.members_)),
+	index_(o.index_.exchange(nullptr, std::memory_order_relaxed)),
+	hash_(o.hash_.exchange(0, std::memory_order_relaxed))
 { }
 
+Object::~Object()
+{
+	drop_index();
+}
+
 Object & Object::operator=(Object const& o)
 {
 	if (&o != this) {
+		drop_index();
 		members_ = o.members_;
+		hash_.store(o.hash_.load(std::memory_order_relaxed), std::memory_order_relaxed);
 	}
 	return *this;
 }
 
-Object & Object::operator=(Object && o)
+Object & Object::operator=(Object && o) noexcept
 {
 	if (&o != this) {
+		// released before the allocator is replaced
+		drop_index();
 		members_ = std::move(o.members_);
+		index_.store(o.index_.exchange(nullptr, std::memory_order_relaxed),
+			std::memory_order_relaxed);
+		hash_.store(o.hash_.exchange(0, std::memory_order_relaxed),
+			std::memory_order_relaxed);
 	}
 	return *this;
 }
@@ -47,12 +173,16 @@ Object & Object::operator=(Object && o)
 Object & Object::operator<<(Member const& member)
 {
 	members_.push_back(member);
+	index_last();
+	hash_.store(0, std::memory_order_relaxed);
 	return *this;
 }
 
 Object & Object::operator<<(Member && member)
 {
 	members_.push_back(std::move(member));
+	index_last();
+	hash_.store(0, std::memory_order_relaxed);
 	return *this;
 }
 
@@ -63,25 +193,85 @@ size_t Object::size() const
 
 std::vector<Member> Object::members() const
 {
-	return members_;
+	return std::vector<Member>(members_.begin(), members_.end());
 }
 
 Value Object::member(std::string const& key) const
 {
+	return as_member(key);
+}
+
+View<Member> Object::as_members() const
+{
+	return View<Member>(members_.data(), members_.size());
+}
+
+Value const& Object::as_member(StringView key) const
+{
+	static const Value invalid;
+
+	ObjectIndex const *index(this->index());
+	if (index) {
+		Member const *member(index->find(members_.data(), key));
+		return member ? member->as_value() : invalid;
+	}
 
 	auto it(std::find_if(members_.begin(), members_.end(),
-		[key](Member const& m) { return m.key().value() == key; }));
-	return it != members_.end() ? it->value() : Value();
+		[&key](Member const& m) { return m.as_key() == key; }));
+	return it != members_.end() ? it->as_value() : invalid;
 }
 
-std::vector<Member>::const_iterator Object::begin() const
+Object::const_iterator Object::begin() const
 {
 	return members_.begin();
 }
 
-std::vector<Member>::const_iterator Object::end() const
+Object::const_iterator Object::end() const
 {
 	return members_.end();
 }
 
+/*
+ * Small objects are searched linearly. Of two threads
+ * building the index at the same time one discards its
+ * own. Objects in an Arena get theirs from the parser,
+ * as the Arena can not be used concurrently.
+ */
+ObjectIndex *Object::index() const
+{
+	ObjectIndex *res(index_.load(std::memory_order_acquire));
+	if (res || members_.size() < index_threshold || members_.size() >= UINT32_MAX) {
+		return res;
+	}
+
+	Arena *arena(members_.get_allocator().arena());
+	res = ObjectIndex::create(arena, members_.size());
+	for (size_t pos(0); pos < members_.size(); ++pos) {
+		res->insert(members_.data(), pos);
+	}
+
+	ObjectIndex *expected(nullptr);
+	if (!index_.compare_exchange_strong(expected, res, std::memory_order_acq_rel)) {
+		ObjectIndex::destroy(arena, res);
+		res = expected;
+	}
+	return res;
+}
+
+// keeps an existing index up to date, a full one is rebuilt later
+void Object::index_last()
+{
+	ObjectIndex *index(index_.load(std::memory_order_relaxed));
+	if (index && (members_.size() >= UINT32_MAX ||
+			!index->insert(members_.data(), members_.size() - 1))) {
+		drop_index();
+	}
+}
+
+void Object::drop_index()
+{
+	ObjectIndex::destroy(members_.get_allocator().arena(),
+		index_.exchange(nullptr, std::memory_order_relaxed));
+}
+
 }
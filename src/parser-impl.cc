@@ -5,310 +5,703 @@
 */
 
 #include <cassert>
+#include <cstdint>
 #include <cstring>
 
 #include "parser-impl.h"
 
+#include "arena.h"
 #include "error.h"
+#include "lazy-document.h"
+#include "parser-states.h"
+#include "structural-index.h"
 #include "token-stream.h"
 #include "utf8stream.h"
 
-namespace {
+namespace Json {
+namespace States {
 
-/*
- * Generic parser state engine
- * Check all transitions for the current State
- * until the token is found in Transition::match,
- * change to the associated state.
- *
- * Instances of this are build for Document, Array and Object
- */
-template <typename State>
-struct Transition {
-	const char *match;
-	State state;
-};
+constexpr Transition<ArrayState::State> ArrayState::transitions[SMAX][SMAX];
+constexpr Transition<ObjectState::State> ObjectState::transitions[SMAX][SMAX];
+constexpr Transition<DocState::State> DocState::transitions[SMAX][SMAX];
 
-template <typename T>
-class StateEngine : public T {
-public:
-	StateEngine(Json::TokenStream & tokenizer_, size_t depth)
-	: T(tokenizer_, depth) { }
+}}
 
-	Json::Value parse()
-	{
-		auto state(T::SSTART);
-		do {
-			T::tokenizer.scan();
-			state = transition(T::tokenizer.token.type, state);
-		} while (state != T::SEND);
+namespace {
+
+using namespace Json::States;
 
-		return std::move(T::result);
+/* literals, strings and numbers */
+Json::Value scalar_value(Json::Token & token, Json::Arena *arena)
+{
+	switch (token.type) {
+	case Json::Token::TRUE_LITERAL:    return Json::True();
+	case Json::Token::FALSE_LITERAL:   return Json::False();
+	case Json::Token::NULL_LITERAL:    return Json::Null();
+	case Json::Token::STRING:
+		return Json::ParserImpl::make_value(token.str_value, arena);
+	case Json::Token::NUMBER:
+		if (token.number_type == Json::Token::FLOAT) {
+			return Json::Number(token.float_value);
+		} else {
+			return Json::Number(token.int_value);
+		}
+		break;
+	case Json::Token::BEGIN_ARRAY:     assert(false); // LCOV_EXCL_LINE
+	case Json::Token::BEGIN_OBJECT:    assert(false); // LCOV_EXCL_LINE
+	case Json::Token::END:             assert(false); // LCOV_EXCL_LINE
+	case Json::Token::INVALID:         assert(false); // LCOV_EXCL_LINE
+	case Json::Token::END_ARRAY:       assert(false); // LCOV_EXCL_LINE
+	case Json::Token::END_OBJECT:      assert(false); // LCOV_EXCL_LINE
+	case Json::Token::NAME_SEPARATOR:  assert(false); // LCOV_EXCL_LINE
+	case Json::Token::VALUE_SEPARATOR: assert(false); // LCOV_EXCL_LINE
 	}
+	JSONCC_THROW(INTERNAL_ERROR);                     // LCOV_EXCL_LINE
+	return Json::Value();
+}
 
-private:
-	typename T::State
-	transition(Json::Token::Type token, typename T::State state)
-	{
-		for (auto t(0); t < T::SMAX; ++t) {
-			if (!is_match(token, T::transitions[state][t].match)) {
-				continue;
-			}
+/* Builder creating a Json::Value tree in the parser frames */
+class TreeBuilder {
+public:
+	typedef Json::ParserImpl::Frame Frame;
 
-			auto nstate(T::transitions[state][t].state);
-			if (nstate == T::SERROR) {
-				T::throw_error(state);
-				JSONCC_THROW(INTERNAL_ERROR); // LCOV_EXCL_LINE
-			} else {
-				T::build(nstate);
-			}
+	// keys is null if keys are not interned
+	TreeBuilder(Json::Arena *arena, Json::ParserImpl::Strings strings,
+			Json::KeyInterner *keys)
+	: result(), arena_(arena), strings_(strings), keys_(keys) { }
 
-			return nstate;
+	void start(Frame & frame)
+	{
+		if (frame.is_object) {
+			frame.object = Json::Object(Json::Allocator<Json::Member>(arena_));
+		} else {
+			frame.array = Json::Array(Json::Allocator<Json::Value>(arena_));
 		}
+	}
 
-		return T::SERROR;
+	void key(Frame & frame, Json::Token & token)
+	{
+		if (keys_ && strings_ == Json::ParserImpl::COPY_STRINGS) {
+			frame.key = Json::ParserImpl::make_key(
+				token.str_value, *keys_, arena_);
+		} else {
+			frame.key = string_value(token);
+		}
 	}
 
-	bool is_match(Json::Token::Type token, const char *match) const
+	void value(Frame & frame, Json::Token & token)
 	{
-		return !match ||
-			(!match[0] && token == Json::Token::END) ||
-			strchr(match, token);
+		if (token.type == Json::Token::STRING) {
+			add(frame, string_value(token));
+		} else {
+			add(frame, scalar_value(token, arena_));
+		}
 	}
-};
 
-/* Base class for state engine configurations */
-class ParserState {
-protected:
-	ParserState(Json::TokenStream & tokenizer_, size_t depth)
-	: tokenizer(tokenizer_), depth_(depth + 1)
+	// parent is null for the outermost container
+	void end(Frame & frame, Frame *parent)
 	{
-		if (depth > 255) {
-			JSONCC_THROW(PARSER_OVERFLOW);
+		Json::Value value(frame.is_object ?
+			Json::ParserImpl::make_value(std::move(frame.object), arena_) :
+			Json::ParserImpl::make_value(std::move(frame.array), arena_));
+		if (parent) {
+			add(*parent, std::move(value));
+		} else {
+			result = std::move(value);
 		}
 	}
 
-	Json::Value parse_value();
+	// drop partial containers while their arena is alive
+	void abort(Frame & frame)
+	{
+		frame.array = Json::Array();
+		frame.object = Json::Object();
+		frame.key = Json::Value();
+	}
 
-	Json::TokenStream & tokenizer;
+	Json::Value result;
 
 private:
-	size_t depth_;
-};
+	Json::Value string_value(Json::Token & token)
+	{
+		Json::StringView str(token.raw, token.str_value.size());
+		switch (strings_) {
+		case Json::ParserImpl::COPY_STRINGS:
+			break;
+		case Json::ParserImpl::BORROW_STRINGS:
+			if (!token.escaped) {
+				return Json::ParserImpl::make_value(str);
+			}
+			break;
+		case Json::ParserImpl::INSITU_STRINGS:
+			return Json::ParserImpl::make_value(insitu(token));
+		}
+		return Json::ParserImpl::make_value(token.str_value, arena_);
+	}
 
-/* State engine config for Json::Array */
-class ArrayState : public ParserState {
-protected:
-	ArrayState(Json::TokenStream & tokenizer_, size_t depth)
-	: ParserState(tokenizer_, depth) { }
-
-	enum State {
-		SERROR = 0,
-		SSTART,
-		SVALUE,
-		SNEXT,
-		SEND,
-		SMAX,
-	};
-
-	void build(State state)
+	/*
+	 * The decoded string is never longer than its source,
+	 * so it fits in place with the terminator written over
+	 * the closing quote at the latest. The tokenizer is past
+	 * that already.
+	 */
+	Json::StringView insitu(Json::Token & token)
 	{
-		switch (state) {
-		case SVALUE: result << parse_value(); break;
-		case SNEXT:  break;
-		case SEND:   break;
-		case SMAX:   assert(false);           // LCOV_EXCL_LINE
-		case SERROR: assert(false);           // LCOV_EXCL_LINE
-		case SSTART: assert(false);           // LCOV_EXCL_LINE
-			JSONCC_THROW(INTERNAL_ERROR); // LCOV_EXCL_LINE
+		char *dst(const_cast<char *>(token.raw));
+		if (token.escaped) {
+			memcpy(dst, token.str_value.data(), token.str_value.size());
 		}
+		dst[token.str_value.size()] = '\0';
+		return Json::StringView(dst, token.str_value.size());
 	}
 
-	void throw_error(State state) const
+	void add(Frame & frame, Json::Value && value)
 	{
-		switch (state) {
-		case SSTART: JSONCC_THROW(BAD_TOKEN_ARRAY_START);
-		case SVALUE: JSONCC_THROW(BAD_TOKEN_ARRAY_VALUE);
-		case SNEXT:  JSONCC_THROW(BAD_TOKEN_ARRAY_NEXT);
-		case SERROR: assert(false); // LCOV_EXCL_LINE
-		case SEND:   assert(false); // LCOV_EXCL_LINE
-		case SMAX:   assert(false); // LCOV_EXCL_LINE
+		if (frame.is_object) {
+			frame.object << Json::ParserImpl::make_member(
+				std::move(frame.key), std::move(value), arena_);
+		} else {
+			frame.array << std::move(value);
 		}
 	}
 
-	Json::Array result;
-	static Transition<State> transitions[SMAX][SMAX];
+	Json::Arena *arena_;
+	Json::ParserImpl::Strings strings_;
+	Json::KeyInterner *keys_;
 };
 
-Transition<ArrayState::State> ArrayState::transitions[SMAX][SMAX] = {
-/* SERROR */ {                                   {0, SERROR}},
-/* SSTART */ {{"[{tfn\"0", SVALUE}, {"]", SEND}, {0, SERROR}},
-/* SVALUE */ {{",",        SNEXT},  {"]", SEND}, {0, SERROR}},
-/* SNEXT  */ {{"[{tfn\"0", SVALUE}, {"]", SEND}, {0, SERROR}},
-/* SEND   */ {                                   {0, SERROR}},
-};
+/* Builder passing the document on to a Json::Handler */
+class HandlerBuilder {
+public:
+	typedef Json::ParserImpl::Frame Frame;
 
-std::string validate_name(std::string const& name)
-{
-	if (name.empty()) {
-		JSONCC_THROW(EMPTY_NAME);
+	explicit HandlerBuilder(Json::Handler & handler)
+	: handler_(handler) { }
+
+	void start(Frame & frame)
+	{
+		if (frame.is_object) {
+			handler_.start_object();
+		} else {
+			handler_.start_array();
+		}
+	}
+
+	void key(Frame &, Json::Token & token)
+	{
+		handler_.key(Json::StringView(token.str_value));
 	}
-	return name;
-}
 
-/* State engine config for Json::Object */
-class ObjectState : public ParserState {
-protected:
-	ObjectState(Json::TokenStream & tokenizer_, size_t depth)
-	: ParserState(tokenizer_, depth) { }
-
-	enum State {
-		SERROR = 0,
-		SSTART,
-		SNAME,
-		SSEP,
-		SVALUE,
-		SNEXT,
-		SEND,
-		SMAX,
-	};
-
-	void build(State state)
+	void value(Frame &, Json::Token & token)
 	{
-		switch (state) {
-		case SNAME:  key = validate_name(tokenizer.token.str_value); break;
-		case SVALUE: result << Json::Member(std::move(key), parse_value()); break;
-		case SNEXT:  break;
-		case SEND:   break;
-		case SSEP:   break;
-		case SERROR: assert(false);           // LCOV_EXCL_LINE
-		case SSTART: assert(false);           // LCOV_EXCL_LINE
-		case SMAX:   assert(false);           // LCOV_EXCL_LINE
+		switch (token.type) {
+		case Json::Token::TRUE_LITERAL:  handler_.boolean(true); break;
+		case Json::Token::FALSE_LITERAL: handler_.boolean(false); break;
+		case Json::Token::NULL_LITERAL:  handler_.null(); break;
+		case Json::Token::STRING:
+			handler_.string(Json::StringView(token.str_value));
+			break;
+		case Json::Token::NUMBER:
+			if (token.number_type == Json::Token::FLOAT) {
+				handler_.number(token.float_value);
+			} else {
+				handler_.number(token.int_value);
+			}
+			break;
+		default:
+			assert(false);                // LCOV_EXCL_LINE
 			JSONCC_THROW(INTERNAL_ERROR); // LCOV_EXCL_LINE
 		}
 	}
 
-	void throw_error(State state) const
+	void end(Frame & frame, Frame *)
 	{
-		switch (state) {
-		case SSTART: JSONCC_THROW(BAD_TOKEN_OBJECT_START);
-		case SNAME:  JSONCC_THROW(BAD_TOKEN_OBJECT_NAME);
-		case SSEP:   JSONCC_THROW(BAD_TOKEN_OBJECT_SEP);
-		case SVALUE: JSONCC_THROW(BAD_TOKEN_OBJECT_VALUE);
-		case SNEXT:  JSONCC_THROW(BAD_TOKEN_OBJECT_NEXT);
-		case SERROR: assert(false); // LCOV_EXCL_LINE
-		case SEND:   assert(false); // LCOV_EXCL_LINE
-		case SMAX:   assert(false); // LCOV_EXCL_LINE
+		if (frame.is_object) {
+			handler_.end_object();
+		} else {
+			handler_.end_array();
 		}
 	}
 
-	std::string key;
-	Json::Object result;
-	static Transition<State> transitions[SMAX][SMAX];
-};
+	void abort(Frame &)
+	{ }
 
-Transition<ObjectState::State> ObjectState::transitions[SMAX][SMAX] = {
-/* SO_ERROR */ {                                   {0, SERROR}},
-/* SO_START */ {{"\"",       SNAME},  {"}", SEND}, {0, SERROR}},
-/* SO_NAME  */ {{":",        SSEP},                {0, SERROR}},
-/* SO_SEP   */ {{"[{tfn\"0", SVALUE},              {0, SERROR}},
-/* SO_VALUE */ {{",",        SNEXT},  {"}", SEND}, {0, SERROR}},
-/* SO_NEXT  */ {{"\"",       SNAME},               {0, SERROR}},
-/* SO_END   */ {                                   {0, SERROR}},
+private:
+	Json::Handler & handler_;
 };
 
-/* State engine config for a Json document */
-class DocState : public ParserState {
-protected:
-	DocState(Json::TokenStream & tokenizer_, size_t & depth)
-	: ParserState(tokenizer_, depth) { }
-
-	enum State {
-		SERROR = 0,
-		SSTART,
-		SVALUE,
-		SEND,
-		SMAX,
-	};
-
-	void build(State state)
+/* Builder recording where the containers of a LazyDocument are */
+class IndexBuilder {
+public:
+	typedef Json::ParserImpl::Frame Frame;
+
+	IndexBuilder(Json::Utf8Stream const& stream, Json::LazyDocumentImpl & doc)
+	: stream_(stream), doc_(doc) { }
+
+	// the bracket has just been read
+	void start(Frame &)
 	{
-		switch (state) {
-		case SVALUE: result = parse_value(); break;
-		case SEND:   break;
-		case SSTART: assert(false);           // LCOV_EXCL_LINE
-		case SERROR: assert(false);           // LCOV_EXCL_LINE
-		case SMAX:   assert(false);           // LCOV_EXCL_LINE
-			JSONCC_THROW(INTERNAL_ERROR); // LCOV_EXCL_LINE
-		}
+		doc_.open.push_back(doc_.spans.size());
+		Json::Span span = {stream_.location().offs - 1, 0, 0};
+		doc_.spans.push_back(span);
 	}
 
-	void throw_error(State state) const
+	void key(Frame &, Json::Token &)
+	{ }
+
+	void value(Frame &, Json::Token &)
+	{ }
+
+	void end(Frame &, Frame *)
 	{
-		switch (state) {
-		case SSTART: JSONCC_THROW(BAD_TOKEN_DOCUMENT);
-		case SVALUE: JSONCC_THROW(BAD_TOKEN_DOCUMENT);
-		case SERROR: assert(false); // LCOV_EXCL_LINE
-		case SEND:   assert(false); // LCOV_EXCL_LINE
-		case SMAX:   assert(false); // LCOV_EXCL_LINE
-		}
+		Json::Span & span(doc_.spans[doc_.open.back()]);
+		doc_.open.pop_back();
+		span.end = stream_.location().offs - 1;
+		span.next = doc_.spans.size();
 	}
 
-	Json::Value result;
-	static Transition<State> transitions[SMAX][SMAX];
-};
+	void abort(Frame &)
+	{ }
 
-Transition<DocState::State> DocState::transitions[SMAX][SMAX] = {
-/* SERROR  */ {                            {0, SERROR}},
-/* SSTART  */ {{"[{", SVALUE}, {"", SEND}, {0, SERROR}},
-/* SVALUE  */ {                {"", SEND}, {0, SERROR}},
-/* SEND    */ {                            {0, SERROR}},
+private:
+	Json::Utf8Stream const& stream_;
+	Json::LazyDocumentImpl & doc_;
 };
 
-/* select recursive parser for nested constructs */
-Json::Value ParserState::parse_value()
-{
-	switch (tokenizer.token.type) {
-	case Json::Token::TRUE_LITERAL:    return Json::True();
-	case Json::Token::FALSE_LITERAL:   return Json::False();
-	case Json::Token::NULL_LITERAL:    return Json::Null();
-	case Json::Token::STRING:          return tokenizer.token.str_value;
-	case Json::Token::NUMBER:
-		if (tokenizer.token.number_type == Json::Token::FLOAT) {
-			return Json::Number(tokenizer.token.float_value);
-		} else {
-			return Json::Number(tokenizer.token.int_value);
+// entries kept for the next parse, larger indexes are released
+const size_t max_kept_index = 1 << 20;
+
+class IndexScope {
+public:
+	explicit IndexScope(std::vector<uint32_t> & index)
+	: index_(index) { }
+
+	~IndexScope()
+	{
+		if (index_.capacity() > max_kept_index) {
+			std::vector<uint32_t>().swap(index_);
 		}
-		break;
-	case Json::Token::BEGIN_ARRAY:
-		return StateEngine<ArrayState>(tokenizer, depth_).parse();
-	case Json::Token::BEGIN_OBJECT:
-		return StateEngine<ObjectState>(tokenizer, depth_).parse();
-	case Json::Token::END:             assert(false); // LCOV_EXCL_LINE
-	case Json::Token::INVALID:         assert(false); // LCOV_EXCL_LINE
-	case Json::Token::END_ARRAY:       assert(false); // LCOV_EXCL_LINE
-	case Json::Token::END_OBJECT:      assert(false); // LCOV_EXCL_LINE
-	case Json::Token::NAME_SEPARATOR:  assert(false); // LCOV_EXCL_LINE
-	case Json::Token::VALUE_SEPARATOR: assert(false); // LCOV_EXCL_LINE
 	}
-	JSONCC_THROW(INTERNAL_ERROR);                     // LCOV_EXCL_LINE
-	return Json::Value();
-}
+
+private:
+	std::vector<uint32_t> & index_;
+};
 
 }
 
 namespace Json {
 
+Handler::~Handler()
+{ }
+
+ParserImpl::ParserImpl()
+:
+	frames_(),
+	depth_(0),
+	max_depth_(DEFAULT_MAX_DEPTH),
+	str_buffer_(),
+	backend_(Parser::TOKEN_STREAM),
+	index_(),
+	keys_()
+{ }
+
+void ParserImpl::set_max_depth(size_t depth)
+{
+	max_depth_ = depth;
+}
+
+size_t ParserImpl::max_depth() const
+{
+	return max_depth_;
+}
+
+void ParserImpl::set_backend(Parser::Backend backend)
+{
+	backend_ = backend;
+}
+
+Parser::Backend ParserImpl::backend() const
+{
+	return backend_;
+}
+
+void ParserImpl::set_key_table(std::shared_ptr<KeyTableImpl> const& table)
+{
+	keys_.set_table(table);
+}
+
+KeyTable::Stats ParserImpl::key_stats() const
+{
+	return keys_.stats;
+}
+
+KeyInterner *ParserImpl::interner()
+{
+	return keys_.table() ? &keys_ : nullptr;
+}
+
 /* Toplevel parser for a single document */
 Value ParserImpl::parse(char const * data, size_t size)
 {
+	if (backend_ == Parser::STRUCTURAL_INDEX && size < index_max_size) {
+		IndexScope scope(index_);
+		try {
+			IndexTokenStream tokenizer(data, size, index_);
+			TreeBuilder builder(nullptr, COPY_STRINGS, interner());
+			parse_tree(tokenizer, builder);
+			return std::move(builder.result);
+		} catch (Error &) {
+			// the token stream reports the error with its location
+		}
+	}
+
 	Utf8Stream utf8stream(data, size);
 	TokenStream tokenizer(utf8stream);
+	TreeBuilder builder(nullptr, COPY_STRINGS, interner());
+	parse_tree(tokenizer, builder);
+	return std::move(builder.result);
+}
+
+/*
+ * Toplevel parser for a single document, nodes go to its arena.
+ * In situ parsing modifies the input, so there is no second try.
+ */
+void ParserImpl::parse(char const * data, size_t size, Document & doc, Strings strings)
+{
+	if (backend_ == Parser::STRUCTURAL_INDEX && strings != INSITU_STRINGS &&
+	    size < index_max_size) {
+		IndexScope scope(index_);
+		try {
+			IndexTokenStream tokenizer(data, size, index_);
+			build(tokenizer, doc, strings);
+			return;
+		} catch (Error &) {
+			// the token stream reports the error with its location
+		}
+	}
+
+	Utf8Stream utf8stream(data, size);
+	TokenStream tokenizer(utf8stream);
+	build(tokenizer, doc, strings);
+}
+
+template <typename Tokens>
+void ParserImpl::build(Tokens & tokenizer, Document & doc, Strings strings)
+{
+	// drop the old tree before its memory is reused
+	doc.root_ = Value();
+	if (!doc.arena_) {
+		doc.arena_.reset(new Arena());
+	}
+	doc.arena_->reset();
+	// the tree refers to the interned keys without counting them
+	doc.keys_ = strings == COPY_STRINGS ? keys_.table() : nullptr;
+
+	TreeBuilder builder(doc.arena_.get(), strings, interner());
+	parse_tree(tokenizer, builder);
+	doc.root_ = std::move(builder.result);
+}
+
+/*
+ * Strings are copied out of the token, so its buffer
+ * is kept for the next parse.
+ */
+template <typename Tokens, typename Builder>
+void ParserImpl::parse_tree(Tokens & tokenizer, Builder & builder)
+{
+	tokenizer.token.str_value.swap(str_buffer_);
+	try {
+		parse(tokenizer, builder);
+	} catch (Error &) {
+		tokenizer.token.str_value.swap(str_buffer_);
+		throw;
+	}
+	tokenizer.token.str_value.swap(str_buffer_);
+}
+
+/* Toplevel parser for a single document, only indexing it */
+void ParserImpl::parse(char const * data, size_t size, LazyDocument & doc)
+{
+	if (!doc.impl_) {
+		doc.impl_.reset(new LazyDocumentImpl());
+	}
+	LazyDocumentImpl & impl(*doc.impl_);
+	impl.clear();
+
+	Utf8Stream utf8stream(data, size);
+	TokenStream tokenizer(utf8stream);
+	IndexBuilder builder(utf8stream, impl);
+	try {
+		parse(tokenizer, builder);
+	} catch (Error &) {
+		impl.clear();
+		throw;
+	}
+
+	impl.data = data;
+	impl.size = size;
+	impl.max_depth = max_depth_;
+}
+
+/* Toplevel parser for a single document, without a tree */
+void ParserImpl::parse(char const * data, size_t size, Handler & handler)
+{
+	Utf8Stream utf8stream(data, size);
+	TokenStream tokenizer(utf8stream);
+	HandlerBuilder builder(handler);
+	parse(tokenizer, builder);
+}
+
+/*
+ * Open an array or object. Frames are kept for the
+ * next container at the same depth, so the stack only
+ * allocates while a parser sees a new maximum depth.
+ */
+template <typename Builder>
+void ParserImpl::push(Token const& token, Builder & builder)
+{
+	if (depth_ >= max_depth_) {
+		JSONCC_THROW(PARSER_OVERFLOW);
+	}
+
+	if (depth_ == frames_.size()) {
+		frames_.emplace_back();
+	}
+
+	Frame & frame(frames_[depth_++]);
+	frame.is_object = token.type == Token::BEGIN_OBJECT;
+	frame.state = ArrayState::SSTART;
+	static_assert(int(ArrayState::SSTART) == int(ObjectState::SSTART), "start states differ");
+	builder.start(frame);
+}
+
+/*
+ * Handle one token in the innermost array, returns true
+ * once it is complete.
+ */
+template <typename Builder>
+bool ParserImpl::build_array(Frame & frame, Token & token, Builder & builder)
+{
+	auto state(StateEngine<ArrayState>::transition(
+		token.type, ArrayState::State(frame.state)));
+	frame.state = state;
+
+	switch (state) {
+	case ArrayState::SVALUE:
+		if (is_container(token.type)) {
+			push(token, builder);
+		} else {
+			builder.value(frame, token);
+		}
+		break;
+	case ArrayState::SNEXT:  break;
+	case ArrayState::SEND:   return true;
+	case ArrayState::SMAX:   assert(false);           // LCOV_EXCL_LINE
+	case ArrayState::SERROR: assert(false);           // LCOV_EXCL_LINE
+	case ArrayState::SSTART: assert(false);           // LCOV_EXCL_LINE
+		JSONCC_THROW(INTERNAL_ERROR);             // LCOV_EXCL_LINE
+	}
+	return false;
+}
+
+/*
+ * Handle one token in the innermost object, returns true
+ * once it is complete.
+ */
+template <typename Builder>
+bool ParserImpl::build_object(Frame & frame, Token & token, Builder & builder)
+{
+	auto state(StateEngine<ObjectState>::transition(
+		token.type, ObjectState::State(frame.state)));
+	frame.state = state;
+
+	switch (state) {
+	case ObjectState::SNAME:
+		validate_name(token.str_value);
+		builder.key(frame, token);
+		break;
+	case ObjectState::SVALUE:
+		if (is_container(token.type)) {
+			push(token, builder);
+		} else {
+			builder.value(frame, token);
+		}
+		break;
+	case ObjectState::SNEXT:  break;
+	case ObjectState::SSEP:   break;
+	case ObjectState::SEND:   return true;
+	case ObjectState::SERROR: assert(false);           // LCOV_EXCL_LINE
+	case ObjectState::SSTART: assert(false);           // LCOV_EXCL_LINE
+	case ObjectState::SMAX:   assert(false);           // LCOV_EXCL_LINE
+		JSONCC_THROW(INTERNAL_ERROR);              // LCOV_EXCL_LINE
+	}
+	return false;
+}
+
+/*
+ * Nested arrays and objects are parsed without recursion,
+ * the open containers are kept in frames_. A completed
+ * container is handed to the one below it, which is
+ * already in its SVALUE state.
+ */
+template <typename Tokens, typename Builder>
+void ParserImpl::parse(Tokens & tokenizer, Builder & builder)
+{
+	depth_ = 0;
+
+	tokenizer.scan();
+	if (StateEngine<DocState>::transition(tokenizer.token.type,
+			DocState::SSTART) == DocState::SEND) {
+		return;
+	}
+
 	try {
-		return StateEngine<DocState>(tokenizer, 0).parse();
-	} catch (Error & e) {
+		push(tokenizer.token, builder);
+		parse_nested(tokenizer, builder);
+	} catch (Error &) {
+		for (size_t i(0); i < depth_; ++i) {
+			builder.abort(frames_[i]);
+		}
 		throw;
 	}
+
+	tokenizer.scan();
+	StateEngine<DocState>::transition(tokenizer.token.type, DocState::SVALUE);
+}
+
+template <typename Tokens, typename Builder>
+void ParserImpl::parse_nested(Tokens & tokenizer, Builder & builder)
+{
+	while (depth_) {
+		tokenizer.scan();
+		Frame & frame(frames_[depth_ - 1]);
+		bool done(frame.is_object ?
+			build_object(frame, tokenizer.token, builder) :
+			build_array(frame, tokenizer.token, builder));
+		if (!done) {
+			continue;
+		}
+
+		--depth_;
+		builder.end(frame, depth_ ? &frames_[depth_ - 1] : nullptr);
+	}
+}
+
+bool ParserImpl::feed(Token & token, Value & value)
+{
+	TreeBuilder builder(nullptr, COPY_STRINGS, interner());
+	try {
+		if (!depth_) {
+			if (StateEngine<DocState>::transition(token.type,
+					DocState::SSTART) != DocState::SEND) {
+				push(token, builder);
+			}
+			return false;
+		}
+
+		Frame & frame(frames_[depth_ - 1]);
+		bool done(frame.is_object ?
+			build_object(frame, token, builder) :
+			build_array(frame, token, builder));
+		if (!done) {
+			return false;
+		}
+
+		--depth_;
+		builder.end(frame, depth_ ? &frames_[depth_ - 1] : nullptr);
+	} catch (Error &) {
+		abort_feed();
+		throw;
+	}
+
+	if (depth_) {
+		return false;
+	}
+	value = std::move(builder.result);
+	return true;
+}
+
+void ParserImpl::expect(Token const& token)
+{
+	try {
+		if (!depth_) {
+			StateEngine<DocState>::transition(token.type, DocState::SSTART);
+			return;
+		}
+
+		Frame const& frame(frames_[depth_ - 1]);
+		if (frame.is_object) {
+			StateEngine<ObjectState>::transition(
+				token.type, ObjectState::State(frame.state));
+		} else {
+			StateEngine<ArrayState>::transition(
+				token.type, ArrayState::State(frame.state));
+		}
+	} catch (Error &) {
+		abort_feed();
+		throw;
+	}
+}
+
+// drop the open containers of a failed feed()
+void ParserImpl::abort_feed()
+{
+	TreeBuilder builder(nullptr, COPY_STRINGS, nullptr);
+	for (size_t i(0); i < depth_; ++i) {
+		builder.abort(frames_[i]);
+	}
+	depth_ = 0;
+}
+
+Value ParserImpl::make_value(StringView str, Arena *arena)
+{
+	return Value(str, arena);
+}
+
+Value ParserImpl::make_value(StringView str)
+{
+	return Value::borrow(str);
+}
+
+Value ParserImpl::make_value(Object && object, Arena *arena)
+{
+	if (arena) {
+		// a Document may be read by several threads
+		object.index();
+		return Value(std::move(object), *arena);
+	}
+	return std::move(object);
+}
+
+Value ParserImpl::make_value(Array && array, Arena *arena)
+{
+	if (arena) {
+		return Value(std::move(array), *arena);
+	}
+	return std::move(array);
+}
+
+/*
+ * Keys in an Arena are not counted, the Document keeps
+ * the whole table instead.
+ */
+Value ParserImpl::make_key(StringView str, KeyInterner & keys, Arena *arena)
+{
+	if (str.size() <= sizeof(Value::Payload::local)) {
+		return make_value(str, arena);
+	}
+
+	InternedKey *key(keys.intern(str));
+	if (arena) {
+		return make_value(key->view());
+	}
+	key->acquire();
+	return Value::interned(key->view());
+}
+
+Member ParserImpl::make_member(Value && key, Value && value, Arena *arena)
+{
+	return Member(std::move(key), std::move(value), arena);
 }
 
 }
@@ -3,14 +3,93 @@
    Use of this source code is governed by a BSD-style
    license that can be found in the LICENSE file.
 */
+#include <vector>
+
 #include <jsoncc.h>
+#include "key-table.h"
 
 namespace Json {
 
+class Token;
+
 class ParserImpl {
 public:
+	ParserImpl();
+
+	// where the strings of a Document tree are stored
+	enum Strings {
+		COPY_STRINGS,   // in the arena
+		BORROW_STRINGS, // in the input if they have no escapes
+		INSITU_STRINGS, // decoded into the input, which is modified
+	};
+
 	Value parse(char const *, size_t);
-	Value parse(char const *, size_t, Error &);
+	void parse(char const *, size_t, Document &, Strings = COPY_STRINGS);
+	void parse(char const *, size_t, LazyDocument &);
+	void parse(char const *, size_t, Handler &);
+
+	/*
+	 * Incremental parsing of a sequence of documents, one
+	 * token at a time, see StreamParser. Returns true with
+	 * the document once its last token was fed, the open
+	 * containers are kept in the frames until then.
+	 */
+	bool feed(Token &, Value &);
+
+	// throws if a token of this type can not come next
+	void expect(Token const&);
+
+	void set_max_depth(size_t);
+	size_t max_depth() const;
+
+	// used for trees, except for in situ parsing
+	void set_backend(Parser::Backend);
+	Parser::Backend backend() const;
+
+	// null stops interning keys
+	void set_key_table(std::shared_ptr<KeyTableImpl> const&);
+	KeyTable::Stats key_stats() const;
+
+	static const size_t DEFAULT_MAX_DEPTH = 255;
+
+	// node construction, without an Arena nodes go to the heap
+	static Value make_value(StringView, Arena *);
+	// refers to the input instead of copying it
+	static Value make_value(StringView);
+	static Value make_value(Object &&, Arena *);
+	static Value make_value(Array &&, Arena *);
+	static Value make_key(StringView, KeyInterner &, Arena *);
+	static Member make_member(Value &&, Value &&, Arena *);
+
+	// an array or object being parsed, the containers are
+	// only used when building a tree
+	struct Frame {
+		bool is_object;
+		int state;
+		Array array;
+		Object object;
+		Value key;
+	};
+
+private:
+	KeyInterner *interner();
+	void abort_feed();
+
+	template <typename Tokens> void build(Tokens &, Document &, Strings);
+	template <typename Tokens, typename Builder> void parse_tree(Tokens &, Builder &);
+	template <typename Tokens, typename Builder> void parse(Tokens &, Builder &);
+	template <typename Tokens, typename Builder> void parse_nested(Tokens &, Builder &);
+	template <typename Builder> void push(Token const&, Builder &);
+	template <typename Builder> bool build_array(Frame &, Token &, Builder &);
+	template <typename Builder> bool build_object(Frame &, Token &, Builder &);
+
+	std::vector<Frame> frames_;
+	size_t depth_;
+	size_t max_depth_;
+	std::string str_buffer_;
+	Parser::Backend backend_;
+	std::vector<uint32_t> index_;
+	KeyInterner keys_;
 };
 
 }
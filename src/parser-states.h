@@ -0,0 +1,270 @@
+/*
+   Copyright (c) 2015 - 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+#ifndef JSON_PARSER_STATES_H
+#define JSON_PARSER_STATES_H
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+
+#include "error.h"
+#include "token-stream.h"
+
+/*
+ * The grammar shared by ParserImpl and ReaderImpl.
+ * The transitions of the state configs are defined
+ * once in parser-impl.cc.
+ */
+namespace Json {
+namespace States {
+
+/*
+ * Generic parser state engine
+ * The first transition of the current State
+ * with the token in Transition::match gives
+ * the next state.
+ *
+ * Instances of this are build for Document, Array and Object
+ */
+template <typename State>
+struct Transition {
+	const char *match;
+	State state;
+};
+
+/*
+ * The transitions are compiled into a dense [state][token class]
+ * table, so the state engine does a single lookup per token.
+ */
+template <size_t... I> struct Indices { };
+
+template <size_t N, size_t... I>
+struct MakeIndices : MakeIndices<N - 1, N - 1, I...> { };
+
+template <size_t... I>
+struct MakeIndices<0, I...> {
+	typedef Indices<I...> type;
+};
+
+constexpr Token::Type token_types[] = {
+	Token::END,
+	Token::INVALID,
+	Token::BEGIN_ARRAY,
+	Token::BEGIN_OBJECT,
+	Token::END_ARRAY,
+	Token::END_OBJECT,
+	Token::NAME_SEPARATOR,
+	Token::VALUE_SEPARATOR,
+	Token::TRUE_LITERAL,
+	Token::FALSE_LITERAL,
+	Token::NULL_LITERAL,
+	Token::STRING,
+	Token::NUMBER,
+};
+
+constexpr size_t token_classes = sizeof(token_types) / sizeof(token_types[0]);
+
+// Token::Type is a char, END maps to 0xff
+constexpr size_t token_class(uint8_t c, size_t i = 0)
+{
+	return i == token_classes ? 0 :
+		uint8_t(token_types[i]) == c ? i : token_class(c, i + 1);
+}
+
+struct TokenClassTable {
+	uint8_t classes[256];
+};
+
+template <size_t... I>
+constexpr TokenClassTable make_token_class_table(Indices<I...>)
+{
+	return TokenClassTable{{uint8_t(token_class(I))...}};
+}
+
+constexpr TokenClassTable token_class_table(
+	make_token_class_table(MakeIndices<256>::type()));
+
+static_assert(token_class_table.classes[uint8_t(Token::END)] == 0 &&
+	token_class_table.classes[uint8_t(Token::NUMBER)] == token_classes - 1,
+	"broken token class table");
+
+// same as the former runtime check with strchr()
+constexpr bool contains(const char *match, char c)
+{
+	return *match == c ? true : *match == '\0' ? false : contains(match + 1, c);
+}
+
+constexpr bool is_match(Token::Type token, const char *match)
+{
+	return !match ||
+		(!match[0] && token == Token::END) ||
+		contains(match, char(token));
+}
+
+template <typename State, size_t N>
+constexpr State find_transition(Transition<State> const (&transitions)[N][N],
+	size_t state, Token::Type token, size_t t = 0)
+{
+	return t == N ? State(0) :
+		is_match(token, transitions[state][t].match) ? transitions[state][t].state :
+		find_transition(transitions, state, token, t + 1);
+}
+
+template <typename State, size_t N>
+struct TransitionTable {
+	State next[N * token_classes];
+};
+
+template <typename State, size_t N, size_t... I>
+constexpr TransitionTable<State, N> make_transition_table(
+	Transition<State> const (&transitions)[N][N], Indices<I...>)
+{
+	return TransitionTable<State, N>{{
+		find_transition(transitions, I / token_classes, token_types[I % token_classes])...}};
+}
+
+template <typename T>
+class StateEngine : public T {
+public:
+	static typename T::State
+	transition(Token::Type token, typename T::State state)
+	{
+		auto nstate(table.next[state * token_classes +
+			token_class_table.classes[uint8_t(token)]]);
+		if (nstate == T::SERROR) {
+			T::throw_error(state);
+			JSONCC_THROW(INTERNAL_ERROR); // LCOV_EXCL_LINE
+		}
+
+		return nstate;
+	}
+
+private:
+	static constexpr TransitionTable<typename T::State, T::SMAX> table =
+		make_transition_table(T::transitions, typename MakeIndices<T::SMAX * token_classes>::type());
+};
+
+template <typename T>
+constexpr TransitionTable<typename T::State, T::SMAX> StateEngine<T>::table;
+
+/* State engine config for Array */
+class ArrayState {
+public:
+	enum State {
+		SERROR = 0,
+		SSTART,
+		SVALUE,
+		SNEXT,
+		SEND,
+		SMAX,
+	};
+
+	static void throw_error(State state)
+	{
+		switch (state) {
+		case SSTART: JSONCC_THROW(BAD_TOKEN_ARRAY_START);
+		case SVALUE: JSONCC_THROW(BAD_TOKEN_ARRAY_VALUE);
+		case SNEXT:  JSONCC_THROW(BAD_TOKEN_ARRAY_NEXT);
+		case SERROR: assert(false); // LCOV_EXCL_LINE
+		case SEND:   assert(false); // LCOV_EXCL_LINE
+		case SMAX:   assert(false); // LCOV_EXCL_LINE
+		}
+	}
+
+	static constexpr Transition<State> transitions[SMAX][SMAX] = {
+	/* SERROR */ {                                   {0, SERROR}},
+	/* SSTART */ {{"[{tfn\"0", SVALUE}, {"]", SEND}, {0, SERROR}},
+	/* SVALUE */ {{",",        SNEXT},  {"]", SEND}, {0, SERROR}},
+	/* SNEXT  */ {{"[{tfn\"0", SVALUE}, {"]", SEND}, {0, SERROR}},
+	/* SEND   */ {                                   {0, SERROR}},
+	};
+};
+
+inline std::string & validate_name(std::string & name)
+{
+	if (name.empty()) {
+		JSONCC_THROW(EMPTY_NAME);
+	}
+	return name;
+}
+
+/* State engine config for Object */
+class ObjectState {
+public:
+	enum State {
+		SERROR = 0,
+		SSTART,
+		SNAME,
+		SSEP,
+		SVALUE,
+		SNEXT,
+		SEND,
+		SMAX,
+	};
+
+	static void throw_error(State state)
+	{
+		switch (state) {
+		case SSTART: JSONCC_THROW(BAD_TOKEN_OBJECT_START);
+		case SNAME:  JSONCC_THROW(BAD_TOKEN_OBJECT_NAME);
+		case SSEP:   JSONCC_THROW(BAD_TOKEN_OBJECT_SEP);
+		case SVALUE: JSONCC_THROW(BAD_TOKEN_OBJECT_VALUE);
+		case SNEXT:  JSONCC_THROW(BAD_TOKEN_OBJECT_NEXT);
+		case SERROR: assert(false); // LCOV_EXCL_LINE
+		case SEND:   assert(false); // LCOV_EXCL_LINE
+		case SMAX:   assert(false); // LCOV_EXCL_LINE
+		}
+	}
+
+	static constexpr Transition<State> transitions[SMAX][SMAX] = {
+	/* SO_ERROR */ {                                   {0, SERROR}},
+	/* SO_START */ {{"\"",       SNAME},  {"}", SEND}, {0, SERROR}},
+	/* SO_NAME  */ {{":",        SSEP},                {0, SERROR}},
+	/* SO_SEP   */ {{"[{tfn\"0", SVALUE},              {0, SERROR}},
+	/* SO_VALUE */ {{",",        SNEXT},  {"}", SEND}, {0, SERROR}},
+	/* SO_NEXT  */ {{"\"",       SNAME},               {0, SERROR}},
+	/* SO_END   */ {                                   {0, SERROR}},
+	};
+};
+
+/* State engine config for a Json document */
+class DocState {
+public:
+	enum State {
+		SERROR = 0,
+		SSTART,
+		SVALUE,
+		SEND,
+		SMAX,
+	};
+
+	static void throw_error(State state)
+	{
+		switch (state) {
+		case SSTART: JSONCC_THROW(BAD_TOKEN_DOCUMENT);
+		case SVALUE: JSONCC_THROW(BAD_TOKEN_DOCUMENT);
+		case SERROR: assert(false); // LCOV_EXCL_LINE
+		case SEND:   assert(false); // LCOV_EXCL_LINE
+		case SMAX:   assert(false); // LCOV_EXCL_LINE
+		}
+	}
+
+	static constexpr Transition<State> transitions[SMAX][SMAX] = {
+	/* SERROR  */ {                            {0, SERROR}},
+	/* SSTART  */ {{"[{", SVALUE}, {"", SEND}, {0, SERROR}},
+	/* SVALUE  */ {                {"", SEND}, {0, SERROR}},
+	/* SEND    */ {                            {0, SERROR}},
+	};
+};
+
+inline bool is_container(Token::Type type)
+{
+	return type == Token::BEGIN_ARRAY || type == Token::BEGIN_OBJECT;
+}
+
+}}
+
+#endif
@@ -5,6 +5,7 @@
 */
 
 #include <jsoncc.h>
+#include "mapped-file.h"
 #include "parser-impl.h"
 
 namespace Json {
@@ -32,4 +33,95 @@ Value Parser::parse(char const * data, size_t size, Error & err)
 	return Value();
 }
 
+void Parser::parse(char const * data, size_t size, Document & doc)
+{
+	impl_->parse(data, size, doc);
+}
+
+void Parser::parse(char const * data, size_t size, Document & doc, Error & err)
+{
+	try {
+		parse(data, size, doc);
+	} catch (Error & e) {
+		err = e;
+	}
+}
+
+void Parser::parse_borrowed(char const * data, size_t size, Document & doc)
+{
+	impl_->parse(data, size, doc, ParserImpl::BORROW_STRINGS);
+}
+
+void Parser::parse_insitu(char * data, size_t size, Document & doc)
+{
+	impl_->parse(data, size, doc, ParserImpl::INSITU_STRINGS);
+}
+
+void Parser::parse(char const * data, size_t size, LazyDocument & doc)
+{
+	impl_->parse(data, size, doc);
+}
+
+void Parser::parse(char const * data, size_t size, Handler & handler)
+{
+	impl_->parse(data, size, handler);
+}
+
+void Parser::parse(char const * data, size_t size, Handler & handler, Error & err)
+{
+	try {
+		parse(data, size, handler);
+	} catch (Error & e) {
+		err = e;
+	}
+}
+
+Value Parser::parse_file(std::string const& path)
+{
+	MappedFile file(path);
+	return parse(file.data(), file.size());
+}
+
+void Parser::parse_file(std::string const& path, Document & doc)
+{
+	MappedFile file(path);
+	parse(file.data(), file.size(), doc);
+}
+
+void Parser::parse_file(std::string const& path, Handler & handler)
+{
+	MappedFile file(path);
+	parse(file.data(), file.size(), handler);
+}
+
+void Parser::set_max_depth(size_t depth)
+{
+	impl_->set_max_depth(depth);
+}
+
+size_t Parser::max_depth() const
+{
+	return impl_->max_depth();
+}
+
+void Parser::set_backend(Backend backend)
+{
+	impl_->set_backend(backend);
+}
+
+Parser::Backend Parser::backend() const
+{
+	return impl_->backend();
+}
+
+void Parser::set_key_table(KeyTable const* table)
+{
+	impl_->set_key_table(table ? table->impl_ : nullptr);
+}
+
+KeyTable::Stats Parser::key_stats() const
+{
+	return impl_->key_stats();
+}
+
 }
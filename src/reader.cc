@@ -0,0 +1,403 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+
+#include <vector>
+
+#include <jsoncc.h>
+#include "error.h"
+#include "parser-impl.h"
+#include "parser-states.h"
+#include "token-stream.h"
+#include "utf8stream.h"
+
+namespace Json {
+
+using namespace States;
+
+/*
+ * Runs the parser state engines one event at a time.
+ * Events are stored in slots so one of them can be
+ * read ahead without losing the current value.
+ */
+class ReaderImpl {
+public:
+	ReaderImpl(char const * data, size_t size)
+	:
+		utf8stream_(data, size),
+		tokenizer_(utf8stream_),
+		doc_state_(DocState::SSTART),
+		frames_(),
+		max_depth_(ParserImpl::DEFAULT_MAX_DEPTH),
+		current_(),
+		ahead_(),
+		has_ahead_(false)
+	{ }
+
+	struct Slot {
+		Slot()
+		:
+			event(Reader::END),
+			int_value(0),
+			float_value(0.0),
+			str_value()
+		{ }
+
+		Reader::Event event;
+		int64_t int_value;
+		double float_value;
+		std::string str_value;
+	};
+
+	Reader::Event next()
+	{
+		if (has_ahead_) {
+			has_ahead_ = false;
+			std::swap(current_, ahead_);
+		} else {
+			advance(current_);
+		}
+		return current_.event;
+	}
+
+	Reader::Event peek_type()
+	{
+		if (!has_ahead_) {
+			advance(ahead_);
+			has_ahead_ = true;
+		}
+		return ahead_.event;
+	}
+
+	// open containers as seen by the caller
+	size_t depth() const
+	{
+		if (!has_ahead_) {
+			return frames_.size();
+		}
+
+		switch (ahead_.event) {
+		case Reader::START_ARRAY:  return frames_.size() - 1;
+		case Reader::START_OBJECT: return frames_.size() - 1;
+		case Reader::END_ARRAY:    return frames_.size() + 1;
+		case Reader::END_OBJECT:   return frames_.size() + 1;
+		default:                   return frames_.size();
+		}
+	}
+
+	Slot const& current() const
+	{
+		return current_;
+	}
+
+	void set_max_depth(size_t depth)
+	{
+		max_depth_ = depth;
+	}
+
+	size_t max_depth() const
+	{
+		return max_depth_;
+	}
+
+private:
+	struct Frame {
+		bool is_object;
+		int state;
+	};
+
+	void advance(Slot & slot)
+	{
+		while (!step(slot)) { }
+	}
+
+	// returns false for tokens without an event
+	bool step(Slot & slot)
+	{
+		if (doc_state_ == DocState::SEND) {
+			slot.event = Reader::END;
+			return true;
+		}
+
+		tokenizer_.scan();
+		Token & token(tokenizer_.token);
+
+		if (frames_.empty()) {
+			doc_state_ = StateEngine<DocState>::transition(token.type, doc_state_);
+			if (doc_state_ == DocState::SEND) {
+				slot.event = Reader::END;
+			} else {
+				push(token, slot);
+			}
+			return true;
+		}
+
+		Frame & frame(frames_.back());
+		if (frame.is_object) {
+			auto state(StateEngine<ObjectState>::transition(
+				token.type, ObjectState::State(frame.state)));
+			frame.state = state;
+
+			switch (state) {
+			case ObjectState::SNAME:
+				slot.event = Reader::KEY;
+				slot.str_value.swap(validate_name(token.str_value));
+				return true;
+			case ObjectState::SVALUE:
+				value(token, slot);
+				return true;
+			case ObjectState::SEND:
+				frames_.pop_back();
+				slot.event = Reader::END_OBJECT;
+				return true;
+			case ObjectState::SNEXT:  break;
+			case ObjectState::SSEP:   break;
+			case ObjectState::SERROR: assert(false);           // LCOV_EXCL_LINE
+			case ObjectState::SSTART: assert(false);           // LCOV_EXCL_LINE
+			case ObjectState::SMAX:   assert(false);           // LCOV_EXCL_LINE
+				JSONCC_THROW(INTERNAL_ERROR);              // LCOV_EXCL_LINE
+			}
+			return false;
+		}
+
+		auto state(StateEngine<ArrayState>::transition(
+			token.type, ArrayState::State(frame.state)));
+		frame.state = state;
+
+		switch (state) {
+		case ArrayState::SVALUE:
+			value(token, slot);
+			return true;
+		case ArrayState::SEND:
+			frames_.pop_back();
+			slot.event = Reader::END_ARRAY;
+			return true;
+		case ArrayState::SNEXT:  break;
+		case ArrayState::SMAX:   assert(false);           // LCOV_EXCL_LINE
+		case ArrayState::SERROR: assert(false);           // LCOV_EXCL_LINE
+		case ArrayState::SSTART: assert(false);           // LCOV_EXCL_LINE
+			JSONCC_THROW(INTERNAL_ERROR);             // LCOV_EXCL_LINE
+		}
+		return false;
+	}
+
+	void push(Token const& token, Slot & slot)
+	{
+		if (frames_.size() >= max_depth_) {
+			JSONCC_THROW(PARSER_OVERFLOW);
+		}
+
+		Frame frame;
+		frame.is_object = token.type == Token::BEGIN_OBJECT;
+		frame.state = ArrayState::SSTART;
+		frames_.push_back(frame);
+		slot.event = frame.is_object ? Reader::START_OBJECT : Reader::START_ARRAY;
+	}
+
+	void value(Token & token, Slot & slot)
+	{
+		switch (token.type) {
+		case Token::TRUE_LITERAL:
+			slot.event = Reader::BOOLEAN;
+			slot.int_value = 1;
+			break;
+		case Token::FALSE_LITERAL:
+			slot.event = Reader::BOOLEAN;
+			slot.int_value = 0;
+			break;
+		case Token::NULL_LITERAL:
+			slot.event = Reader::NULL_VALUE;
+			break;
+		case Token::STRING:
+			slot.event = Reader::STRING;
+			slot.str_value.swap(token.str_value);
+			break;
+		case Token::NUMBER:
+			if (token.number_type == Token::FLOAT) {
+				slot.event = Reader::FLOAT;
+				slot.float_value = token.float_value;
+			} else {
+				slot.event = Reader::INT;
+				slot.int_value = token.int_value;
+			}
+			break;
+		case Token::BEGIN_ARRAY:
+		case Token::BEGIN_OBJECT:
+			push(token, slot);
+			break;
+		case Token::END:             assert(false); // LCOV_EXCL_LINE
+		case Token::INVALID:         assert(false); // LCOV_EXCL_LINE
+		case Token::END_ARRAY:       assert(false); // LCOV_EXCL_LINE
+		case Token::END_OBJECT:      assert(false); // LCOV_EXCL_LINE
+		case Token::NAME_SEPARATOR:  assert(false); // LCOV_EXCL_LINE
+		case Token::VALUE_SEPARATOR: assert(false); // LCOV_EXCL_LINE
+			JSONCC_THROW(INTERNAL_ERROR);       // LCOV_EXCL_LINE
+		}
+	}
+
+	Utf8Stream utf8stream_;
+	TokenStream tokenizer_;
+	DocState::State doc_state_;
+	std::vector<Frame> frames_;
+	size_t max_depth_;
+	Slot current_;
+	Slot ahead_;
+	bool has_ahead_;
+};
+
+Reader::Reader(char const * data, size_t size)
+:
+	impl_(new ReaderImpl(data, size))
+{ }
+
+Reader::~Reader()
+{ }
+
+void Reader::set_max_depth(size_t depth)
+{
+	impl_->set_max_depth(depth);
+}
+
+size_t Reader::max_depth() const
+{
+	return impl_->max_depth();
+}
+
+Reader::Event Reader::next()
+{
+	return impl_->next();
+}
+
+Reader::Event Reader::peek_type()
+{
+	return impl_->peek_type();
+}
+
+Reader::Event Reader::event() const
+{
+	return impl_->current().event;
+}
+
+size_t Reader::depth() const
+{
+	return impl_->depth();
+}
+
+bool Reader::boolean() const
+{
+	return impl_->current().int_value != 0;
+}
+
+int64_t Reader::int_value() const
+{
+	return impl_->current().int_value;
+}
+
+double Reader::float_value() const
+{
+	return impl_->current().float_value;
+}
+
+StringView Reader::string() const
+{
+	return StringView(impl_->current().str_value);
+}
+
+void Reader::expect(Event event)
+{
+	if (next() != event) {
+		JSONCC_THROW(UNEXPECTED_EVENT);
+	}
+}
+
+void Reader::read_null()
+{
+	expect(NULL_VALUE);
+}
+
+bool Reader::read_bool()
+{
+	expect(BOOLEAN);
+	return boolean();
+}
+
+int64_t Reader::read_int()
+{
+	expect(INT);
+	return int_value();
+}
+
+double Reader::read_double()
+{
+	switch (next()) {
+	case INT:   return int_value();
+	case FLOAT: return float_value();
+	default:    break;
+	}
+	JSONCC_THROW(UNEXPECTED_EVENT);
+}
+
+std::string Reader::read_string()
+{
+	expect(STRING);
+	return string().str();
+}
+
+void Reader::enter_array()
+{
+	expect(START_ARRAY);
+}
+
+void Reader::enter_object()
+{
+	expect(START_OBJECT);
+}
+
+bool Reader::next_element()
+{
+	if (peek_type() != END_ARRAY) {
+		return true;
+	}
+	next();
+	return false;
+}
+
+bool Reader::next_key()
+{
+	switch (next()) {
+	case KEY:        return true;
+	case END_OBJECT: return false;
+	default:         break;
+	}
+	JSONCC_THROW(UNEXPECTED_EVENT);
+}
+
+void Reader::skip_value()
+{
+	size_t nested(0);
+	do {
+		switch (next()) {
+		case START_ARRAY:  ++nested; break;
+		case START_OBJECT: ++nested; break;
+		case END_ARRAY:
+		case END_OBJECT:
+			if (nested == 0) {
+				JSONCC_THROW(UNEXPECTED_EVENT);
+			}
+			--nested;
+			break;
+		case KEY:
+		case END:
+			if (nested == 0) {
+				JSONCC_THROW(UNEXPECTED_EVENT);
+			}
+			break;
+		default:
+			break;
+		}
+	} while (nested);
+}
+
+}
@@ -0,0 +1,83 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+
+#ifndef JSON_REF_COUNT_H
+#define JSON_REF_COUNT_H
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace Json {
+
+/*
+ * Reference count in front of a payload on the heap,
+ * the payload is shared by the copies of a Value. The
+ * payload pointer stays the one the Value stores, the
+ * count is found at a fixed offset before it.
+ */
+struct RefCount {
+	RefCount() : refs(1) { }
+
+	std::atomic<size_t> refs;
+};
+
+// keeps the payload after the count aligned
+const size_t ref_count_size = alignof(std::max_align_t);
+
+static_assert(sizeof(RefCount) <= ref_count_size, "RefCount does not fit");
+
+inline RefCount & ref_count(void const* payload)
+{
+	return *reinterpret_cast<RefCount *>(
+		const_cast<char *>(static_cast<char const*>(payload)) - ref_count_size);
+}
+
+template <typename T, typename... Args>
+T *counted_new(Args&&... args)
+{
+	static_assert(alignof(T) <= ref_count_size, "payload alignment not supported");
+
+	char *mem(static_cast<char *>(::operator new(ref_count_size + sizeof(T))));
+	new (mem) RefCount();
+	try {
+		return new (mem + ref_count_size) T(std::forward<Args>(args)...);
+	} catch (...) {
+		::operator delete(mem);
+		throw;
+	}
+}
+
+// uninitialized chars
+inline char *counted_chars(size_t size)
+{
+	char *mem(static_cast<char *>(::operator new(ref_count_size + size)));
+	new (mem) RefCount();
+	return mem + ref_count_size;
+}
+
+template <typename T>
+void counted_acquire(T const* payload)
+{
+	ref_count(payload).refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+// the last reference destroys the payload
+template <typename T>
+void counted_release(T *payload)
+{
+	RefCount & count(ref_count(payload));
+	if (count.refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		payload->~T();
+		count.~RefCount();
+		::operator delete(&count);
+	}
+}
+
+}
+
+#endif
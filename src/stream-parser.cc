@@ -0,0 +1,139 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+
+#include <deque>
+
+#include <jsoncc.h>
+#include "error.h"
+#include "parser-impl.h"
+#include "token-stream.h"
+
+namespace Json {
+
+/*
+ * Tokens go to a ParserImpl as soon as they are complete,
+ * which keeps the open containers of the current document
+ * between chunks. A token split between chunks is kept by
+ * the ChunkTokenStream. Its type is checked at the end of
+ * each chunk, so a token that can not come next fails
+ * without waiting for the rest of it.
+ */
+class StreamParserImpl {
+public:
+	StreamParserImpl()
+	:
+		parser_(),
+		tokens_(),
+		values_()
+	{ }
+
+	void feed(char const * data, size_t size)
+	{
+		tokens_.feed(data, size);
+		try {
+			scan();
+			if (tokens_.pending() != Token::INVALID) {
+				parser_.expect(tokens_.token);
+			}
+		} catch (Error & e) {
+			e.location = Location(tokens_.offset());
+			throw;
+		}
+	}
+
+	void finish()
+	{
+		tokens_.finish();
+		try {
+			scan();
+		} catch (Error & e) {
+			e.location = Location(tokens_.offset());
+			throw;
+		}
+	}
+
+	bool next(Value & value)
+	{
+		if (values_.empty()) {
+			return false;
+		}
+
+		value = std::move(values_.front());
+		values_.pop_front();
+		return true;
+	}
+
+	size_t buffered() const
+	{
+		return tokens_.buffered();
+	}
+
+	void set_max_depth(size_t depth)
+	{
+		parser_.set_max_depth(depth);
+	}
+
+	size_t max_depth() const
+	{
+		return parser_.max_depth();
+	}
+
+private:
+	// errors are located by the caller
+	void scan()
+	{
+		Value value;
+		while (tokens_.scan()) {
+			if (parser_.feed(tokens_.token, value)) {
+				values_.push_back(std::move(value));
+			}
+		}
+	}
+
+	ParserImpl parser_;
+	ChunkTokenStream tokens_;
+	std::deque<Value> values_;
+};
+
+StreamParser::StreamParser()
+:
+	impl_(new StreamParserImpl())
+{ }
+
+StreamParser::~StreamParser()
+{ }
+
+void StreamParser::set_max_depth(size_t depth)
+{
+	impl_->set_max_depth(depth);
+}
+
+size_t StreamParser::max_depth() const
+{
+	return impl_->max_depth();
+}
+
+void StreamParser::feed(char const * data, size_t size)
+{
+	impl_->feed(data, size);
+}
+
+void StreamParser::finish()
+{
+	impl_->finish();
+}
+
+bool StreamParser::next(Value & value)
+{
+	return impl_->next(value);
+}
+
+size_t StreamParser::buffered() const
+{
+	return impl_->buffered();
+}
+
+}
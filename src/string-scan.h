@@ -0,0 +1,78 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+
+#ifndef JSON_STRING_SCAN_H
+#define JSON_STRING_SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace Json {
+
+inline bool is_string_special(uint8_t c)
+{
+	return c == '"' || c == '\\' || c <= 0x1f;
+}
+
+/*
+ * Length of the prefix of [p, p + size) that can be copied
+ * into a string verbatim, that is up to the first quote,
+ * backslash or control char. Works on 32 or 16 bytes at a
+ * time where the target supports it.
+ */
+inline size_t find_string_special(const char *p, size_t size)
+{
+	size_t i(0);
+
+#if defined(__AVX2__)
+	const __m256i quote32(_mm256_set1_epi8('"'));
+	const __m256i bslash32(_mm256_set1_epi8('\\'));
+	const __m256i ctrl32(_mm256_set1_epi8(0x1f));
+	for (; i + 32 <= size; i += 32) {
+		__m256i v(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i)));
+		__m256i m(_mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, quote32), _mm256_cmpeq_epi8(v, bslash32)),
+			// v <= 0x1f unsigned
+			_mm256_cmpeq_epi8(_mm256_max_epu8(v, ctrl32), ctrl32)));
+		uint32_t mask(_mm256_movemask_epi8(m));
+		if (mask) {
+			return i + __builtin_ctz(mask);
+		}
+	}
+#endif
+
+#if defined(__SSE2__)
+	const __m128i quote16(_mm_set1_epi8('"'));
+	const __m128i bslash16(_mm_set1_epi8('\\'));
+	const __m128i ctrl16(_mm_set1_epi8(0x1f));
+	for (; i + 16 <= size; i += 16) {
+		__m128i v(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i)));
+		__m128i m(_mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(v, quote16), _mm_cmpeq_epi8(v, bslash16)),
+			_mm_cmpeq_epi8(_mm_max_epu8(v, ctrl16), ctrl16)));
+		uint32_t mask(_mm_movemask_epi8(m));
+		if (mask) {
+			return i + __builtin_ctz(mask);
+		}
+	}
+#endif
+
+	for (; i < size; ++i) {
+		if (is_string_special(p[i])) {
+			break;
+		}
+	}
+
+	return i;
+}
+
+}
+
+#endif
@@ -27,6 +27,11 @@ String::String(std::string const& value)
 	value_(value)
 { }
 
+String::String(std::string && value)
+:
+	value_(std::move(value))
+{ }
+
 String::String(const char *value)
 :
 	value_(value)
@@ -53,4 +58,9 @@ std::string String::value() const
 	return value_;
 }
 
+std::string const& String::str() const
+{
+	return value_;
+}
+
 }
@@ -0,0 +1,402 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "error.h"
+#include "structural-index.h"
+#include "utf8.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define JSONCC_INDEX_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(JSONCC_INDEX_AVX2)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+enum CharBits : uint8_t {
+	BQUOTE  = 1,
+	BSLASH  = 2,
+	BOP     = 4,
+	BSPACE  = 8,
+	BCTRL   = 16,
+};
+
+struct CharTable {
+	CharTable()
+	:
+		bits()
+	{
+		for (size_t c(0); c < 0x20; ++c) {
+			bits[c] = BCTRL;
+		}
+		bits[uint8_t('"')] = BQUOTE;
+		bits[uint8_t('\\')] = BSLASH;
+		for (char c : {'[', ']', '{', '}', ':', ','}) {
+			bits[uint8_t(c)] = BOP;
+		}
+		for (char c : {' ', '\t', '\r', '\n'}) {
+			bits[uint8_t(c)] |= BSPACE;
+		}
+	}
+
+	uint8_t bits[256];
+};
+
+const CharTable char_table;
+
+// one bit per byte of a 64 byte block
+struct Masks {
+	uint64_t quote;
+	uint64_t backslash;
+	uint64_t op;
+	uint64_t space;
+	uint64_t ctrl;
+};
+
+#if defined(__SSE2__)
+inline __m128i eq(__m128i v, char c)
+{
+	return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+}
+
+inline uint64_t mask16(__m128i v, size_t i)
+{
+	return uint64_t(uint16_t(_mm_movemask_epi8(v))) << (16 * i);
+}
+
+Masks classify(char const * p)
+{
+	Masks res = {0, 0, 0, 0, 0};
+	for (size_t i(0); i < 4; ++i) {
+		__m128i v(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * i)));
+		// brackets and braces differ in bit 5 only
+		__m128i low(_mm_or_si128(v, _mm_set1_epi8(0x20)));
+		res.quote |= mask16(eq(v, '"'), i);
+		res.backslash |= mask16(eq(v, '\\'), i);
+		res.op |= mask16(_mm_or_si128(
+			_mm_or_si128(eq(low, '{'), eq(low, '}')),
+			_mm_or_si128(eq(v, ':'), eq(v, ','))), i);
+		res.space |= mask16(_mm_or_si128(
+			_mm_or_si128(eq(v, ' '), eq(v, '\t')),
+			_mm_or_si128(eq(v, '\r'), eq(v, '\n'))), i);
+		// v <= 0x1f unsigned
+		__m128i ctrl(_mm_set1_epi8(0x1f));
+		res.ctrl |= mask16(_mm_cmpeq_epi8(_mm_max_epu8(v, ctrl), ctrl), i);
+	}
+	return res;
+}
+#else
+Masks classify(char const * p)
+{
+	Masks res = {0, 0, 0, 0, 0};
+	for (size_t i(0); i < 64; ++i) {
+		uint8_t bits(char_table.bits[uint8_t(p[i])]);
+		uint64_t bit(uint64_t(1) << i);
+		res.quote |= bits & BQUOTE ? bit : 0;
+		res.backslash |= bits & BSLASH ? bit : 0;
+		res.op |= bits & BOP ? bit : 0;
+		res.space |= bits & BSPACE ? bit : 0;
+		res.ctrl |= bits & BCTRL ? bit : 0;
+	}
+	return res;
+}
+#endif
+
+#ifdef JSONCC_INDEX_AVX2
+__attribute__((target("avx2")))
+inline __m256i eq_avx2(__m256i v, char c)
+{
+	return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+}
+
+__attribute__((target("avx2")))
+inline uint64_t mask32(__m256i v, size_t i)
+{
+	return uint64_t(uint32_t(_mm256_movemask_epi8(v))) << (32 * i);
+}
+
+__attribute__((target("avx2")))
+inline Masks classify_avx2(char const * p)
+{
+	Masks res = {0, 0, 0, 0, 0};
+	for (size_t i(0); i < 2; ++i) {
+		__m256i v(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32 * i)));
+		__m256i low(_mm256_or_si256(v, _mm256_set1_epi8(0x20)));
+		res.quote |= mask32(eq_avx2(v, '"'), i);
+		res.backslash |= mask32(eq_avx2(v, '\\'), i);
+		res.op |= mask32(_mm256_or_si256(
+			_mm256_or_si256(eq_avx2(low, '{'), eq_avx2(low, '}')),
+			_mm256_or_si256(eq_avx2(v, ':'), eq_avx2(v, ','))), i);
+		res.space |= mask32(_mm256_or_si256(
+			_mm256_or_si256(eq_avx2(v, ' '), eq_avx2(v, '\t')),
+			_mm256_or_si256(eq_avx2(v, '\r'), eq_avx2(v, '\n'))), i);
+		__m256i ctrl(_mm256_set1_epi8(0x1f));
+		res.ctrl |= mask32(_mm256_cmpeq_epi8(_mm256_max_epu8(v, ctrl), ctrl), i);
+	}
+	return res;
+}
+#endif
+
+/*
+ * Bit i of the result is the xor of bits 0 to i, it marks
+ * the bytes from an opening quote up to the closing one.
+ */
+inline uint64_t prefix_xor(uint64_t x)
+{
+	x ^= x << 1;
+	x ^= x << 2;
+	x ^= x << 4;
+	x ^= x << 8;
+	x ^= x << 16;
+	x ^= x << 32;
+	return x;
+}
+
+#ifdef JSONCC_INDEX_AVX2
+// the same as a carry-less multiplication by all ones
+__attribute__((target("pclmul,sse2")))
+inline uint64_t prefix_xor_clmul(uint64_t x)
+{
+	return _mm_cvtsi128_si64(_mm_clmulepi64_si128(
+		_mm_set_epi64x(0, x), _mm_set1_epi8(char(0xff)), 0));
+}
+#endif
+
+/*
+ * Chars following a backslash which is not escaped itself.
+ * Backslashes are rare, so they are walked one by one.
+ * carry is set if the last byte of the block escapes the
+ * first one of the next.
+ */
+inline uint64_t escaped(uint64_t backslash, uint64_t & carry)
+{
+	uint64_t res(carry);
+	backslash &= ~carry;
+	carry = 0;
+	while (backslash) {
+		unsigned i(__builtin_ctzll(backslash));
+		if (i == 63) {
+			carry = 1;
+			break;
+		}
+		res |= uint64_t(2) << i;
+		backslash &= ~(uint64_t(3) << i);
+	}
+	return res;
+}
+
+// the 64 bytes at base, the tail is padded with whitespace
+inline char const *block(char const * data, size_t size, size_t base, char (&tail)[64])
+{
+	if (size - base >= 64) {
+		return data + base;
+	}
+
+	memset(tail, ' ', sizeof(tail));
+	memcpy(tail, data + base, size - base);
+	return tail;
+}
+
+/*
+ * The part of stage one after the classification, which
+ * is the same for all instruction sets.
+ */
+class Blocks {
+public:
+	explicit Blocks(std::vector<uint32_t> & index)
+	:
+		index_(index),
+		escape_carry_(0),
+		string_carry_(0),
+		other_carry_(0)
+	{ }
+
+	// quotes which are not escaped
+	uint64_t quotes(Masks const& masks)
+	{
+		return masks.quote & ~escaped(masks.backslash, escape_carry_);
+	}
+
+	// takes the prefix_xor() of the quotes
+	void add(size_t base, Masks const& masks, uint64_t quote, uint64_t prefix)
+	{
+		uint64_t in_string(prefix ^ string_carry_);
+		string_carry_ = uint64_t(int64_t(in_string) >> 63);
+
+		uint64_t other(~(masks.op | masks.space | quote | in_string));
+		uint64_t starts(other & ~(other << 1 | other_carry_));
+		other_carry_ = other >> 63;
+
+		uint64_t entries((masks.op & ~in_string) | quote | starts);
+		size_t first(index_.size());
+		for (uint64_t bits(entries); bits; bits &= bits - 1) {
+			index_.push_back(base + __builtin_ctzll(bits));
+		}
+
+		/*
+		 * Strings hold no entries, so the last entry before a
+		 * backslash or control char in a string is its quote.
+		 */
+		uint64_t special((masks.backslash | masks.ctrl) & in_string);
+		for (; special; special &= special - 1) {
+			uint64_t before((uint64_t(1) << __builtin_ctzll(special)) - 1);
+			index_[first + __builtin_popcountll(entries & before) - 1] |= Json::index_decode;
+		}
+	}
+
+	bool in_string() const
+	{
+		return string_carry_;
+	}
+
+private:
+	std::vector<uint32_t> & index_;
+	uint64_t escape_carry_;
+	uint64_t string_carry_; // all ones inside a string
+	uint64_t other_carry_;  // the last byte belongs to a literal or number
+};
+
+void index_blocks(char const * data, size_t size, Blocks & blocks)
+{
+	for (size_t base(0); base < size; base += 64) {
+		char tail[64];
+		Masks masks(classify(block(data, size, base, tail)));
+		uint64_t quote(blocks.quotes(masks));
+		blocks.add(base, masks, quote, prefix_xor(quote));
+	}
+}
+
+#ifdef JSONCC_INDEX_AVX2
+__attribute__((target("avx2,pclmul")))
+void index_blocks_avx2(char const * data, size_t size, Blocks & blocks)
+{
+	for (size_t base(0); base < size; base += 64) {
+		char tail[64];
+		Masks masks(classify_avx2(block(data, size, base, tail)));
+		uint64_t quote(blocks.quotes(masks));
+		blocks.add(base, masks, quote, prefix_xor_clmul(quote));
+	}
+}
+
+bool have_avx2()
+{
+	static const bool res((__builtin_cpu_init(),
+		__builtin_cpu_supports("avx2") && __builtin_cpu_supports("pclmul")));
+	return res;
+}
+#endif
+
+bool is_space(char c)
+{
+	return char_table.bits[uint8_t(c)] & BSPACE;
+}
+
+}
+
+namespace Json {
+
+void structural_index(char const * data, size_t size, std::vector<uint32_t> & index)
+{
+	assert(size < index_max_size);
+	index.clear();
+
+	Error::Type error(Error::OK);
+	if (utf8_validate(data, 0, size, error) != size) {
+		throw Error(error);
+	}
+
+	Blocks blocks(index);
+#ifdef JSONCC_INDEX_AVX2
+	if (have_avx2()) {
+		index_blocks_avx2(data, size, blocks);
+	} else {
+		index_blocks(data, size, blocks);
+	}
+#else
+	index_blocks(data, size, blocks);
+#endif
+
+	if (blocks.in_string()) {
+		JSONCC_THROW(STRING_QUOTE);
+	}
+}
+
+IndexTokenStream::IndexTokenStream(char const * data, size_t size, std::vector<uint32_t> & index)
+:
+	token(),
+	data_(data),
+	size_(size),
+	index_(index),
+	pos_(0),
+	stream_(data, size),
+	tokens_(stream_)
+{
+	structural_index(data, size, index);
+}
+
+void IndexTokenStream::scan()
+{
+	token.reset();
+	if (pos_ == index_.size()) {
+		token.type = Token::END;
+		return;
+	}
+
+	size_t entry(index_[pos_++]);
+	size_t offs(entry & ~index_decode);
+	switch (data_[offs]) {
+	case '[': case '{': case ']':
+	case '}': case ':': case ',':
+		token.type = Token::Type(data_[offs]);
+		break;
+	case '"':
+		scan_string(offs, entry & index_decode);
+		break;
+	default: {
+		// a literal or number up to the next space or entry
+		size_t end(pos_ < index_.size() ? index_[pos_] & ~index_decode : size_);
+		while (end > offs && is_space(data_[end - 1])) {
+			--end;
+		}
+		scan_token(offs, end);
+		break;
+	}
+	}
+}
+
+// the closing quote is the next entry
+void IndexTokenStream::scan_string(size_t offs, bool decode)
+{
+	size_t end(index_[pos_++] + 1);
+	if (decode) {
+		// escapes and errors are left to the tokenizer
+		scan_token(offs, end);
+		return;
+	}
+
+	token.type = Token::STRING;
+	token.raw = data_ + offs + 1;
+	token.str_value.assign(token.raw, end - offs - 2);
+}
+
+void IndexTokenStream::scan_token(size_t offs, size_t end)
+{
+	stream_.seek(offs);
+	tokens_.scan();
+	if (stream_.location().offs != end) {
+		JSONCC_THROW(TOKEN_INVALID);
+	}
+	std::swap(token, tokens_.token);
+}
+
+}
@@ -0,0 +1,72 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+#ifndef JSON_STRUCTURAL_INDEX_H
+#define JSON_STRUCTURAL_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "token-stream.h"
+#include "utf8stream.h"
+
+namespace Json {
+
+/*
+ * Stage one: offsets of every token start in the input,
+ * that is the structural chars, all quotes outside of
+ * escapes, and the first char of each literal or number.
+ * Found 64 bytes at a time with bit masks, so whitespace
+ * and the contents of strings are never looked at one by
+ * one. Uses AVX2 and PCLMUL where the cpu has them. Throws
+ * Json::Error for invalid utf8 and for an unterminated
+ * string, without a location. The input has to be shorter
+ * than index_max_size.
+ */
+void structural_index(char const *, size_t, std::vector<uint32_t> &);
+
+/*
+ * Set in the entry of an opening quote if the string has
+ * escapes or control chars, other strings are copied as
+ * they are.
+ */
+const uint32_t index_decode(uint32_t(1) << 31);
+
+// offsets have to fit in the entries next to index_decode
+const size_t index_max_size(index_decode);
+
+/*
+ * Stage two: the tokens at the offsets of the index, with
+ * the interface of TokenStream for ParserImpl. Strings
+ * marked for decoding and scalars are read by a
+ * TokenStream placed at their offset, which has to end
+ * at the next entry. Errors may
+ * differ from the ones of a TokenStream over the whole
+ * input, the parser falls back to that to report them.
+ */
+class IndexTokenStream {
+public:
+	IndexTokenStream(char const *, size_t, std::vector<uint32_t> &);
+
+	void scan(); // throws Json::Error
+
+	Token token;
+
+private:
+	void scan_string(size_t, bool);
+	void scan_token(size_t, size_t);
+
+	char const *data_;
+	size_t size_;
+	std::vector<uint32_t> const& index_;
+	size_t pos_;
+	Utf8Stream stream_;
+	TokenStream tokens_;
+};
+
+}
+
+#endif
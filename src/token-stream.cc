@@ -4,12 +4,14 @@
    license that can be found in the LICENSE file.
 */
 
-#include <cerrno>
-#include <cstdlib>
-#include <cstring>
+#include <cassert>
+#include <cstdint>
 
 #include "error.h"
+#include "float-parse.h"
+#include "string-scan.h"
 #include "token-stream.h"
+#include "utf8.h"
 #include "utf8stream.h"
 
 namespace {
@@ -19,50 +21,19 @@ bool is_ws(int c)
 	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
 }
 
-uint64_t make_int(const char *str)
+double make_float(const char *str, size_t size)
 {
-	errno = 0;
-	char *endp(0);
-	auto res(strtoll(str, &endp, 10));
-	if (*endp != '\0' || errno != 0) {
+	double res;
+	if (!Json::parse_double(str, str + size, res)) {
 		JSONCC_THROW(NUMBER_INVALID);
 	}
 	return res;
 }
 
-// POSIX thread local locale setting.
-class AutoLocale {
-public:
-	explicit AutoLocale(const char *name)
-	:
-		locale_(newlocale(LC_ALL_MASK, name, 0)),
-		saved_(uselocale(locale_))
-	{ }
-
-	~AutoLocale()
-	{
-		uselocale(saved_);
-		freelocale(locale_);
-	}
+// number tokens have to be shorter than this
+const size_t max_number_length = 1024;
 
-private:
-	locale_t locale_;
-	locale_t saved_;
-};
-
-long double make_float(const char *str)
-{
-	errno = 0;
-	char *endp(0);
-	AutoLocale lc("C");
-	auto res(strtold(str, &endp));
-	if (*endp != '\0' || errno != 0) {
-		JSONCC_THROW(NUMBER_INVALID);
-	}
-	return res;
-}
-
-enum NumberState {
+enum NumberState : uint8_t {
 	SSTART = 0,
 	SMINUS,
 	SINT_ZERO,
@@ -78,77 +49,165 @@ enum NumberState {
 	SERROR,
 };
 
-NumberState number_state(int c, NumberState state)
-{
-#define DIGIT19 "123456789"
-#define DIGIT "0" DIGIT19
-	struct {
-		const char *match;
-		NumberState state;
-	} transitions[][4] = {
-	/* SSTART       */ {{"-", SMINUS},   {"0", SINT_ZERO},  {DIGIT19, SINT_DIGIT19}, {0, SERROR}},
-	/* SMINUS       */ {                 {"0", SINT_ZERO},  {DIGIT19, SINT_DIGIT19}, {0, SERROR}},
-	/* SINT_ZERO    */ {{"eE", SE},      {".", SDEC_POINT},                          {0, SDONE} },
-	/* SINT_DIGIT   */ {{"eE", SE},      {".", SDEC_POINT}, {DIGIT, SINT_DIGIT},     {0, SDONE} },
-	/* SINT_DIGIT19 */ {{"eE", SE},      {".", SDEC_POINT}, {DIGIT, SINT_DIGIT},     {0, SDONE} },
-	/* SDEC_POINT   */ {{"eE", SE},                         {DIGIT, SFRAC_DIGIT},    {0, SERROR}},
-	/* SFRAC_DIGIT  */ {{"eE", SE},                         {DIGIT, SFRAC_DIGIT},    {0, SDONE} },
-	/* SE           */ {{"-", SE_MINUS}, {"+", SE_PLUS},    {DIGIT, SE_DIGIT},       {0, SERROR}},
-	/* SE_PLUS      */ {                                    {DIGIT, SE_DIGIT},       {0, SERROR}},
-	/* SE_MINUS     */ {                                    {DIGIT, SE_DIGIT},       {0, SERROR}},
-	/* SE_DIGIT     */ {                                    {DIGIT, SE_DIGIT},       {0, SDONE} },
-	};
+enum CharClass : uint8_t {
+	COTHER = 0,
+	CZERO,
+	CDIGIT, // 1-9
+	CMINUS,
+	CPLUS,
+	CDOT,
+	CEXP,
+	CMAX,
+};
 
-	for (auto t(0); true; ++t) {
-		auto *match(transitions[state][t].match);
-		if (!match || strchr(match, c)) {
-			return transitions[state][t].state;
-		}
-	}
+const CharClass char_classes[256] = {
+	/* 00 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* 08 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* 10 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* 18 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* 20 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* 28 */ COTHER, COTHER, COTHER, CPLUS, COTHER, CMINUS, CDOT, COTHER,
+	/* 30 */ CZERO, CDIGIT, CDIGIT, CDIGIT, CDIGIT, CDIGIT, CDIGIT, CDIGIT,
+	/* 38 */ CDIGIT, CDIGIT, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* 40 */ COTHER, COTHER, COTHER, COTHER, COTHER, CEXP, COTHER, COTHER,
+	/* 48 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* 50 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* 58 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* 60 */ COTHER, COTHER, COTHER, COTHER, COTHER, CEXP, COTHER, COTHER,
+	/* 68 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* 70 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* 78 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* 80 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* 88 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* 90 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* 98 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* a0 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* a8 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* b0 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* b8 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* c0 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* c8 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* d0 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* d8 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* e0 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* e8 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* f0 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+	/* f8 */ COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER, COTHER,
+};
 
-	return SERROR;
+// EOF maps to 0xff which is never part of a number
+CharClass char_class(int c)
+{
+	return char_classes[static_cast<uint8_t>(c)];
 }
 
-Json::Token::NumberType
-validate_number(Json::Utf8Stream & stream, char *buf, size_t size)
-{
-	auto state(SSTART);
-	auto res(Json::Token::INT);
-	auto i(0U);
-	for (;;) {
-		auto c(stream.getc());
-		state = number_state(c, state);
+const NumberState number_transitions[SDONE][CMAX] = {
+/*                   OTHER   ZERO         DIGIT         MINUS     PLUS     DOT          EXP */
+/* SSTART       */ {SERROR, SINT_ZERO,   SINT_DIGIT19, SMINUS,   SERROR,  SERROR,      SERROR},
+/* SMINUS       */ {SERROR, SINT_ZERO,   SINT_DIGIT19, SERROR,   SERROR,  SERROR,      SERROR},
+/* SINT_ZERO    */ {SDONE,  SDONE,       SDONE,        SDONE,    SDONE,   SDEC_POINT,  SE},
+/* SINT_DIGIT   */ {SDONE,  SINT_DIGIT,  SINT_DIGIT,   SDONE,    SDONE,   SDEC_POINT,  SE},
+/* SINT_DIGIT19 */ {SDONE,  SINT_DIGIT,  SINT_DIGIT,   SDONE,    SDONE,   SDEC_POINT,  SE},
+/* SDEC_POINT   */ {SERROR, SFRAC_DIGIT, SFRAC_DIGIT,  SERROR,   SERROR,  SERROR,      SE},
+/* SFRAC_DIGIT  */ {SDONE,  SFRAC_DIGIT, SFRAC_DIGIT,  SDONE,    SDONE,   SDONE,       SE},
+/* SE           */ {SERROR, SE_DIGIT,    SE_DIGIT,     SE_MINUS, SE_PLUS, SERROR,      SERROR},
+/* SE_PLUS      */ {SERROR, SE_DIGIT,    SE_DIGIT,     SERROR,   SERROR,  SERROR,      SERROR},
+/* SE_MINUS     */ {SERROR, SE_DIGIT,    SE_DIGIT,     SERROR,   SERROR,  SERROR,      SERROR},
+/* SE_DIGIT     */ {SDONE,  SE_DIGIT,    SE_DIGIT,     SDONE,    SDONE,   SDONE,       SDONE},
+};
 
-		switch (state) {
-		case SSTART:
+/*
+ * A number fed one char at a time. Integers are accumulated
+ * while validating, an integer out of the int64_t range
+ * is only an error if the number does not turn out to be
+ * a float. Floats are converted from the input bytes.
+ */
+class NumberScan {
+public:
+	NumberScan()
+	:
+		state_(SSTART),
+		type_(Json::Token::INT),
+		negative_(false),
+		overflow_(false),
+		value_(0),
+		length_(0)
+	{ }
+
+	// false if c is not part of the number any more
+	bool scan(int c)
+	{
+		state_ = number_transitions[state_][char_class(c)];
+
+		switch (state_) {
+		case SMINUS:
+			negative_ = true;
 			break;
+		case SINT_DIGIT:
+		case SINT_DIGIT19: {
+			uint64_t digit(c - '0');
+			uint64_t limit(negative_ ? uint64_t(INT64_MAX) + 1 : uint64_t(INT64_MAX));
+			if (value_ > (limit - digit) / 10) {
+				overflow_ = true;
+			} else {
+				value_ = value_ * 10 + digit;
+			}
+			break;
+		}
 		case SDEC_POINT:
 		case SE:
-			res = Json::Token::FLOAT;
-			// fallthrough
-		case SMINUS:
+			type_ = Json::Token::FLOAT;
+			break;
+		case SSTART:
 		case SINT_ZERO:
-		case SINT_DIGIT:
-		case SINT_DIGIT19:
 		case SFRAC_DIGIT:
-		case SE_MINUS:
 		case SE_PLUS:
+		case SE_MINUS:
 		case SE_DIGIT:
-			buf[i] = c;
-			if (++i == size) {
-				JSONCC_THROW(NUMBER_OVERFLOW);
-			}
 			break;
 		case SERROR:
 			JSONCC_THROW(NUMBER_INVALID);
 		case SDONE:
-			buf[i] = '\0';
-			stream.ungetc();
-			return res;
+			return false;
+		}
+
+		if (++length_ == max_number_length) {
+			JSONCC_THROW(NUMBER_OVERFLOW);
+		}
+		return true;
+	}
+
+	// takes the chars of the number
+	void result(Json::Token & token, const char *str, size_t size) const
+	{
+		token.number_type = type_;
+		if (type_ == Json::Token::FLOAT) {
+			token.float_value = make_float(str, size);
+		} else if (overflow_) {
+			JSONCC_THROW(NUMBER_INVALID);
+		} else {
+			token.int_value = negative_ ? int64_t(0 - value_) : int64_t(value_);
 		}
 	}
 
-	return Json::Token::NONE;
+private:
+	NumberState state_;
+	Json::Token::NumberType type_;
+	bool negative_;
+	bool overflow_;
+	uint64_t value_;
+	size_t length_;
+};
+
+// single pass over a number
+void lex_number(Json::Utf8Stream & stream, Json::Token & token)
+{
+	size_t begin(stream.location().offs);
+	NumberScan number;
+	while (number.scan(stream.getc())) { }
+
+	stream.ungetc();
+	number.result(token, stream.data() + begin, stream.location().offs - begin);
 }
 
 enum StringState {
@@ -336,7 +395,16 @@ void TokenStream::scan_string()
 {
 	auto state(SREGULAR);
 	UEscape unicode;
+	token.raw = stream_.data() + stream_.location().offs;
 	while (state != SDONES) {
+		if (state == SREGULAR) {
+			// only quotes, escapes and errors take the slow path
+			auto run(stream_.string_run());
+			token.str_value.append(run.data(), run.size());
+		} else {
+			token.escaped = true;
+		}
+
 		auto c(stream_.getc());
 		if (stream_.state() != Utf8Stream::SGOOD) {
 			JSONCC_THROW(STRING_QUOTE);
@@ -360,19 +428,368 @@ void TokenStream::scan_string()
 
 void TokenStream::scan_number()
 {
-	char buf[1024];
-	token.number_type = validate_number(stream_, buf, sizeof(buf));
-	switch (token.number_type) {
-	case Token::INT:
-		token.int_value = make_int(buf);
-		break;
-	case Token::FLOAT:
-		token.float_value = make_float(buf);
-		break;
-	case Token::NONE:
-		token.reset();
-		break;
+	lex_number(stream_, token);
+}
+
+/*
+ * The state of ChunkTokenStream. Each chunk is validated
+ * as a whole when it is fed, up to the first bad byte,
+ * which is only reported once the scanner gets there.
+ */
+class ChunkScanner {
+public:
+	ChunkScanner()
+	:
+		data_(nullptr),
+		size_(0),
+		pos_(0),
+		checked_(0),
+		base_(0),
+		error_(Error::OK),
+		utf8_(),
+		kind_(KNONE),
+		literal_(nullptr),
+		number_(),
+		digits_(),
+		string_(SREGULAR),
+		unicode_(),
+		finished_(false),
+		ended_(false),
+		bad_(false)
+	{ }
+
+	void feed(const char *data, size_t size)
+	{
+		base_ += pos_;
+		data_ = data;
+		size_ = size;
+		pos_ = 0;
+		validate();
+	}
+
+	void finish()
+	{
+		feed(nullptr, 0);
+		finished_ = true;
+	}
+
+	bool scan(Token & token)
+	{
+		if (bad_) {
+			return false;
+		}
+
+		try {
+			return next(token);
+		} catch (Error & e) {
+			bad_ = true;
+			kind_ = KNONE;
+			token.reset();
+			e.location = Location(offset());
+			throw;
+		}
+	}
+
+	Token::Type pending(Token const& token) const
+	{
+		return kind_ == KNONE ? Token::INVALID : token.type;
 	}
+
+	size_t buffered(Token const& token) const
+	{
+		switch (kind_) {
+		case KSTRING: return token.str_value.size();
+		case KNUMBER: return digits_.size();
+		case KLITERAL: break;
+		case KNONE: break;
+		}
+		return 0;
+	}
+
+	size_t offset() const
+	{
+		return base_ + pos_;
+	}
+
+private:
+	// the token being scanned
+	enum Kind {
+		KNONE,
+		KLITERAL,
+		KNUMBER,
+		KSTRING,
+	};
+
+	/*
+	 * Sets checked_ to the valid prefix of the chunk. A
+	 * sequence truncated at its end is continued by utf8_
+	 * in the next chunk.
+	 */
+	void validate()
+	{
+		checked_ = 0;
+		error_ = Error::OK;
+		for (; checked_ < size_ && !utf8_.idle(); ++checked_) {
+			if (data_[checked_] == '\0') {
+				error_ = Error::STREAM_ZERO;
+				return;
+			}
+			if (!utf8_.validate(data_[checked_])) {
+				error_ = Error::UTF8_INVALID;
+				return;
+			}
+		}
+		if (checked_ == size_) {
+			return;
+		}
+
+		size_t begin(checked_);
+		checked_ = begin + utf8_validate(data_ + begin, 0, size_ - begin, error_);
+		if (checked_ != size_) {
+			return;
+		}
+
+		size_t lead(size_);
+		while (lead > begin && size_ - lead < 3 && (uint8_t(data_[lead - 1]) & 0xc0) == 0x80) {
+			--lead;
+		}
+		if (lead == begin || uint8_t(data_[lead - 1]) < 0xc0) {
+			return;
+		}
+		for (--lead; lead < size_; ++lead) {
+			utf8_.validate(data_[lead]);
+		}
+	}
+
+	// false at the end of the chunk, throws at a bad byte
+	bool available() const
+	{
+		if (pos_ < checked_) {
+			return true;
+		}
+		if (error_ != Error::OK) {
+			throw Error(error_);
+		}
+		return false;
+	}
+
+	bool next(Token & token)
+	{
+		if (kind_ == KNONE) {
+			for (;;) {
+				if (!available()) {
+					if (!finished_ || ended_) {
+						return false;
+					}
+					ended_ = true;
+					token.reset();
+					token.type = Token::END;
+					return true;
+				}
+				if (!is_ws(data_[pos_])) {
+					break;
+				}
+				++pos_;
+			}
+
+			token.reset();
+			if (start(token)) {
+				return true;
+			}
+		}
+
+		switch (kind_) {
+		case KLITERAL: return scan_literal();
+		case KNUMBER:  return scan_number(token);
+		case KSTRING:  return scan_string(token);
+		case KNONE:    assert(false); // LCOV_EXCL_LINE
+		}
+		return false; // LCOV_EXCL_LINE
+	}
+
+	// true if the token is complete with its first char
+	bool start(Token & token)
+	{
+		char c(data_[pos_]);
+		switch (c) {
+		case '[': case '{': case ']':
+		case '}': case ':': case ',':
+			++pos_;
+			token.type = Token::Type(c);
+			return true;
+		case 't':
+			literal_ = "true";
+			break;
+		case 'f':
+			literal_ = "false";
+			break;
+		case 'n':
+			literal_ = "null";
+			break;
+		case '"':
+			++pos_;
+			token.type = Token::STRING;
+			kind_ = KSTRING;
+			string_ = SREGULAR;
+			unicode_ = UEscape();
+			return false;
+		case '-':
+		case '0': case '1': case '2': case '3': case '4':
+		case '5': case '6': case '7': case '8': case '9':
+			token.type = Token::NUMBER;
+			kind_ = KNUMBER;
+			number_ = NumberScan();
+			digits_.clear();
+			return false;
+		default:
+			++pos_;
+			JSONCC_THROW(TOKEN_INVALID);
+		}
+
+		++pos_;
+		++literal_;
+		token.type = Token::Type(c);
+		kind_ = KLITERAL;
+		return false;
+	}
+
+	bool scan_literal()
+	{
+		for (; *literal_; ++literal_) {
+			if (!available()) {
+				if (!finished_) {
+					return false;
+				}
+				JSONCC_THROW(LITERAL_INVALID);
+			}
+			if (data_[pos_++] != *literal_) {
+				JSONCC_THROW(LITERAL_INVALID);
+			}
+		}
+
+		kind_ = KNONE;
+		return true;
+	}
+
+	bool scan_number(Token & token)
+	{
+		for (;;) {
+			int c(Utf8Stream::SEOF);
+			if (available()) {
+				c = uint8_t(data_[pos_++]);
+			} else if (!finished_) {
+				return false;
+			}
+
+			if (!number_.scan(c)) {
+				if (c != Utf8Stream::SEOF) {
+					--pos_;
+				}
+				break;
+			}
+			digits_.push_back(c);
+		}
+
+		kind_ = KNONE;
+		number_.result(token, digits_.data(), digits_.size());
+		return true;
+	}
+
+	bool scan_string(Token & token)
+	{
+		for (;;) {
+			if (string_ == SREGULAR) {
+				size_t run(find_string_special(data_ + pos_, checked_ - pos_));
+				token.str_value.append(data_ + pos_, run);
+				pos_ += run;
+			} else {
+				token.escaped = true;
+			}
+
+			if (!available()) {
+				if (!finished_) {
+					return false;
+				}
+				JSONCC_THROW(STRING_QUOTE);
+			}
+
+			int c(uint8_t(data_[pos_++]));
+			switch (string_) {
+			case SREGULAR:
+				string_ = scan_regular(c, token.str_value);
+				break;
+			case SESCAPED:
+				string_ = scan_escaped(c, token.str_value);
+				break;
+			case SUESCAPE:
+				string_ = unicode_.scan(c, token.str_value);
+				break;
+			case SDONES:
+				break;
+			}
+
+			if (string_ == SDONES) {
+				kind_ = KNONE;
+				return true;
+			}
+		}
+	}
+
+	const char *data_;
+	size_t size_;
+	size_t pos_;
+	size_t checked_;
+	size_t base_; // offset of the chunk in the input
+	Error::Type error_;
+	utf8validator utf8_;
+	Kind kind_;
+	const char *literal_; // the chars still expected
+	NumberScan number_;
+	std::string digits_;
+	StringState string_;
+	UEscape unicode_;
+	bool finished_;
+	bool ended_;
+	bool bad_;
+};
+
+ChunkTokenStream::ChunkTokenStream()
+:
+	token(),
+	scanner_(new ChunkScanner())
+{ }
+
+ChunkTokenStream::~ChunkTokenStream()
+{ }
+
+void ChunkTokenStream::feed(const char *data, size_t size)
+{
+	scanner_->feed(data, size);
+}
+
+void ChunkTokenStream::finish()
+{
+	scanner_->finish();
+}
+
+bool ChunkTokenStream::scan()
+{
+	return scanner_->scan(token);
+}
+
+Token::Type ChunkTokenStream::pending() const
+{
+	return scanner_->pending(token);
+}
+
+size_t ChunkTokenStream::buffered() const
+{
+	return scanner_->buffered(token);
+}
+
+size_t ChunkTokenStream::offset() const
+{
+	return scanner_->offset();
 }
 
 }
@@ -3,7 +3,11 @@
    Use of this source code is governed by a BSD-style
    license that can be found in the LICENSE file.
 */
+#ifndef JSON_TOKEN_STREAM_H
+#define JSON_TOKEN_STREAM_H
+
 #include <cinttypes>
+#include <memory>
 #include <string>
 
 namespace Json {
@@ -33,16 +37,22 @@ public:
 	} number_type;
 
 	int64_t int_value;
-	long double float_value;
+	double float_value;
 	std::string str_value;
+	// start of a string in the input, null for other tokens
+	char const *raw;
+	// raw is only equal to str_value without escapes
+	bool escaped;
 
 	Token()
 	:
 		type(INVALID),
 		number_type(NONE),
 		int_value(0),
-		float_value(0.0L),
-		str_value()
+		float_value(0.0),
+		str_value(),
+		raw(nullptr),
+		escaped(false)
 	{ }
 
 	void reset()
@@ -50,8 +60,10 @@ public:
 		type = INVALID;
 		number_type = NONE;
 		int_value = 0;
-		float_value = 0.0L;
+		float_value = 0.0;
 		str_value.clear();
+		raw = nullptr;
+		escaped = false;
 	}
 };
 
@@ -80,4 +92,51 @@ private:
 	Utf8Stream & stream_;
 };
 
+class ChunkScanner;
+
+/*
+ * Tokens of an input arriving in chunks, see StreamParser.
+ * A chunk may end anywhere in a token or utf8 sequence, the
+ * scanner keeps its state and goes on with the next chunk.
+ * Only the chars of a partial string or number are held.
+ * Error locations are offsets in the whole input.
+ */
+class ChunkTokenStream {
+public:
+	ChunkTokenStream();
+	~ChunkTokenStream();
+
+	// the chunk has to stay valid until scan() returns false
+	void feed(const char *, size_t);
+
+	// no more chunks follow
+	void finish();
+
+	/*
+	 * Scan the next token, false if the chunk ends before it
+	 * is complete. After finish() the last token is END.
+	 * Throws Json::Error.
+	 */
+	bool scan();
+
+	// type of the token the chunk ended in, INVALID if none
+	Token::Type pending() const;
+
+	// chars held for a pending string or number
+	size_t buffered() const;
+
+	// of the next char in the whole input
+	size_t offset() const;
+
+	Token token;
+
+private:
+	ChunkTokenStream(ChunkTokenStream const&) = delete;
+	ChunkTokenStream & operator=(ChunkTokenStream const&) = delete;
+
+	std::unique_ptr<ChunkScanner> scanner_;
+};
+
 }
+
+#endif
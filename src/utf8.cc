@@ -0,0 +1,228 @@
+/*
+   Copyright (c) 2019 Andreas Fett. All rights reserved.
+   Use of this source code is governed by a BSD-style
+   license that can be found in the LICENSE file.
+*/
+
+#include <cstring>
+
+#include "utf8.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define JSONCC_UTF8_SSSE3
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const uint64_t high_bits(0x8080808080808080ULL);
+const uint64_t low_bits(0x0101010101010101ULL);
+
+/*
+ * Start of the sequence crossing begin, it is checked again
+ * as the bytes following begin decide whether it is valid.
+ */
+size_t sequence_start(const uint8_t *buf, size_t begin)
+{
+	size_t start(begin);
+	while (begin - start < 3 && start > 0 && (buf[start - 1] & 0xc0) == 0x80) {
+		--start;
+	}
+	if (start > 0 && buf[start - 1] >= 0xc0) {
+		--start;
+	}
+	return start;
+}
+
+/*
+ * Reference implementation, skips 8 byte words of
+ * ASCII without NUL bytes between sequences.
+ */
+size_t validate_scalar(const uint8_t *buf, size_t begin, size_t end, Json::Error::Type & error)
+{
+	Json::utf8validator utf8;
+	for (size_t i(sequence_start(buf, begin)); i < end;) {
+		if (utf8.idle() && i + 8 <= end) {
+			uint64_t word;
+			memcpy(&word, buf + i, sizeof(word));
+			bool has_zero((word - low_bits) & ~word & high_bits);
+			if (!(word & high_bits) && !has_zero) {
+				i += 8;
+				continue;
+			}
+		}
+
+		if (buf[i] == '\0') {
+			error = Json::Error::STREAM_ZERO;
+			return i;
+		}
+		if (!utf8.validate(buf[i])) {
+			error = Json::Error::UTF8_INVALID;
+			return i;
+		}
+		++i;
+	}
+
+	return end;
+}
+
+#ifdef JSONCC_UTF8_SSSE3
+
+/*
+ * Range checks by table lookup as described in
+ * "Validating UTF-8 In Less Than One Instruction Per Byte"
+ * (Keiser, Lemire). Each pair of bytes is classified by the
+ * high and low nibble of the first byte and the high nibble
+ * of the second byte, the three lookups share an error bit
+ * only if the pair is invalid. Multibyte lengths are checked
+ * by comparing the bytes two and three positions back.
+ *
+ * This only says if a block is bad, the exact offset comes
+ * from the scalar validator.
+ */
+enum : uint8_t {
+	TOO_SHORT      = 1 << 0,
+	TOO_LONG       = 1 << 1,
+	OVERLONG_3     = 1 << 2,
+	TOO_LARGE      = 1 << 3,
+	SURROGATE      = 1 << 4,
+	OVERLONG_2     = 1 << 5,
+	TOO_LARGE_1000 = 1 << 6,
+	OVERLONG_4     = 1 << 6,
+	TWO_CONTS      = 1 << 7,
+	CARRY          = TOO_SHORT | TOO_LONG | TWO_CONTS,
+};
+
+__attribute__((target("ssse3")))
+inline __m128i nibble_lookup(__m128i table, __m128i nibbles)
+{
+	return _mm_shuffle_epi8(table, nibbles);
+}
+
+__attribute__((target("ssse3")))
+bool block_error(__m128i input, __m128i prev)
+{
+	const __m128i low_nibble(_mm_set1_epi8(0x0f));
+
+	const __m128i byte_1_high_table(_mm_setr_epi8(
+		TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+		TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+		TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+		TOO_SHORT | OVERLONG_2,
+		TOO_SHORT,
+		TOO_SHORT | OVERLONG_3 | SURROGATE,
+		TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4));
+
+	const __m128i byte_1_low_table(_mm_setr_epi8(
+		CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+		CARRY | OVERLONG_2,
+		CARRY,
+		CARRY,
+		CARRY | TOO_LARGE,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000));
+
+	const __m128i byte_2_high_table(_mm_setr_epi8(
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT));
+
+	__m128i prev1(_mm_alignr_epi8(input, prev, 15));
+	__m128i byte_1_high(nibble_lookup(byte_1_high_table,
+		_mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble)));
+	__m128i byte_1_low(nibble_lookup(byte_1_low_table,
+		_mm_and_si128(prev1, low_nibble)));
+	__m128i byte_2_high(nibble_lookup(byte_2_high_table,
+		_mm_and_si128(_mm_srli_epi16(input, 4), low_nibble)));
+	__m128i special(_mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high));
+
+	// third and fourth bytes of a sequence must be continuations
+	__m128i prev2(_mm_alignr_epi8(input, prev, 14));
+	__m128i prev3(_mm_alignr_epi8(input, prev, 13));
+	__m128i must23(_mm_or_si128(
+		_mm_subs_epu8(prev2, _mm_set1_epi8(char(0xe0 - 1))),
+		_mm_subs_epu8(prev3, _mm_set1_epi8(char(0xf0 - 1)))));
+	__m128i must23_80(_mm_andnot_si128(
+		_mm_cmpeq_epi8(must23, _mm_setzero_si128()), _mm_set1_epi8(char(0x80))));
+
+	__m128i error(_mm_xor_si128(must23_80, special));
+	error = _mm_or_si128(error, _mm_cmpeq_epi8(input, _mm_setzero_si128()));
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) != 0xffff;
+}
+
+__attribute__((target("ssse3")))
+size_t validate_ssse3(const uint8_t *buf, size_t begin, size_t end, Json::Error::Type & error)
+{
+	// sequence started in prev still needs continuation bytes
+	const __m128i incomplete(_mm_setr_epi8(
+		char(0xff), char(0xff), char(0xff), char(0xff),
+		char(0xff), char(0xff), char(0xff), char(0xff),
+		char(0xff), char(0xff), char(0xff), char(0xff),
+		char(0xff), char(0xf0 - 1), char(0xe0 - 1), char(0xc0 - 1)));
+
+	size_t i(begin);
+	if (i != 0 && i < 16) {
+		return validate_scalar(buf, begin, end, error);
+	}
+
+	__m128i prev(i ? _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + i - 16))
+		: _mm_setzero_si128());
+	for (; i + 16 <= end; i += 16) {
+		__m128i input(_mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + i)));
+		bool bad;
+		if (!_mm_movemask_epi8(input)) {
+			// ASCII only
+			__m128i zero(_mm_cmpeq_epi8(input, _mm_setzero_si128()));
+			__m128i open(_mm_subs_epu8(prev, incomplete));
+			bad = _mm_movemask_epi8(zero) ||
+				_mm_movemask_epi8(_mm_cmpeq_epi8(open, _mm_setzero_si128())) != 0xffff;
+		} else {
+			bad = block_error(input, prev);
+		}
+
+		if (bad) {
+			return validate_scalar(buf, begin, end, error);
+		}
+		prev = input;
+	}
+
+	return validate_scalar(buf, i, end, error);
+}
+
+bool have_ssse3()
+{
+	static const bool res((__builtin_cpu_init(), __builtin_cpu_supports("ssse3")));
+	return res;
+}
+
+#endif
+
+}
+
+namespace Json {
+
+size_t utf8_validate(const char *buf, size_t begin, size_t end, Error::Type & error)
+{
+	auto *ubuf(reinterpret_cast<const uint8_t *>(buf));
+#ifdef JSONCC_UTF8_SSSE3
+	if (have_ssse3()) {
+		return validate_ssse3(ubuf, begin, end, error);
+	}
+#endif
+	return validate_scalar(ubuf, begin, end, error);
+}
+
+}
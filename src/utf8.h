@@ -8,6 +8,7 @@
 #define JSON_UTF8_H
 
 #include <cassert>
+#include <jsoncc.h>
 
 /* utf8 state engine
  *
@@ -81,6 +82,12 @@ public:
 		return (state_ = next_state(c)) != -1;
 	}
 
+	// true between sequences
+	bool idle() const
+	{
+		return state_ == 0;
+	}
+
 private:
 	int next_state(unsigned char c) const
 	{
@@ -110,6 +117,15 @@ private:
 	int state_ = 0;
 };
 
+/*
+ * Block wise check of buf[begin, end) for NUL bytes and invalid
+ * utf8. buf[0, begin) has to be valid already, a sequence may
+ * continue across begin. Returns the offset of the first bad
+ * byte and sets the error type, or returns end. A sequence
+ * truncated at end is not an error, the next call continues it.
+ */
+size_t utf8_validate(const char *buf, size_t begin, size_t end, Error::Type &);
+
 }
 
 #endif
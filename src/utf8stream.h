@@ -8,10 +8,17 @@
 #define JSON_UTF8_STREAM_H
 
 #include <jsoncc.h>
+#include "string-scan.h"
 #include "utf8.h"
 
 namespace Json {
 
+/*
+ * Input validation runs ahead of the reader in chunks, see
+ * utf8_validate(). Bytes up to checked_ are known to be good,
+ * an error found beyond the read position is only reported
+ * once the reader gets there.
+ */
 class Utf8Stream {
 public:
 	enum State {
@@ -27,8 +34,8 @@ public:
 		pos_(0),
 		bad_(false),
 		eof_(false),
-		utf8_(),
-		valid_(0)
+		checked_(0),
+		error_(Error::OK)
 	{ }
 
 	State state() const
@@ -50,26 +57,42 @@ public:
 			return SBAD;
 		}
 
-		if (pos_ == len_) {
+		if (pos_ == checked_ && !check()) {
 			eof_ = true;
 			return SEOF;
 		}
 
-		uint8_t c(buf_[pos_]);
-		if (c == '\0') {
-			bad_ = true;
-			throw Error(Error::STREAM_ZERO, location());
+		return static_cast<uint8_t>(buf_[pos_++]);
+	}
+
+	/*
+	 * Consume the bytes up to the next quote, backslash or
+	 * control char. The terminating byte or error is left
+	 * for getc().
+	 */
+	StringView string_run()
+	{
+		if (bad_) {
+			return StringView();
 		}
 
-		if (valid_ <= pos_) {
-			if ((bad_ = !utf8_.validate(c))) {
-				throw Error(Error::UTF8_INVALID, location());
+		size_t start(pos_);
+		for (;;) {
+			pos_ += find_string_special(buf_ + pos_, checked_ - pos_);
+			if (pos_ != checked_ || !check_ahead()) {
+				break;
 			}
-			++valid_;
 		}
 
-		++pos_;
-		return c;
+		return StringView(buf_ + start, pos_ - start);
+	}
+
+	// continue at pos, for input validated as a whole beforehand
+	void seek(size_t pos)
+	{
+		pos_ = pos;
+		checked_ = len_;
+		eof_ = false;
 	}
 
 	void ungetc()
@@ -84,19 +107,54 @@ public:
 		return Location(pos_);
 	}
 
+	// the input, valid up to the current position
+	const char *data() const
+	{
+		return buf_;
+	}
+
 	void bad()
 	{
 		bad_ = true;
 	}
 
 private:
+	// validate the next chunk, false at the end or an error
+	bool check_ahead()
+	{
+		if (error_ != Error::OK || checked_ == len_) {
+			return false;
+		}
+
+		size_t end(len_ - checked_ > chunk_size ? checked_ + chunk_size : len_);
+		checked_ = utf8_validate(buf_, checked_, end, error_);
+		return pos_ != checked_;
+	}
+
+	// throws at the offset of a validation error
+	bool check()
+	{
+		if (check_ahead()) {
+			return true;
+		}
+
+		if (error_ != Error::OK) {
+			bad_ = true;
+			throw Error(error_, location());
+		}
+
+		return false;
+	}
+
+	static const size_t chunk_size = 64 * 1024;
+
 	const char *buf_;
 	size_t len_;
 	size_t pos_;
 	bool bad_;
 	bool eof_;
-	utf8validator utf8_;
-	size_t valid_;
+	size_t checked_;
+	Error::Type error_;
 };
 
 }
@@ -6,162 +6,341 @@
 #include <jsoncc.h>
 #include <cstring>
 #include <cassert>
+#include <new>
+
+#include "arena.h"
+#include "key-table.h"
+#include "ref-count.h"
 
 namespace Json {
 
+static_assert(sizeof(Value) <= 24, "Value layout is not compact");
+
 static True TrueValue;
 static False FalseValue;
 static Null NullValue;
 
 Value::Value()
 :
-	tag_(TAG_INVALID)
+	payload_(),
+	tag_(TAG_INVALID),
+	storage_(STORAGE_LOCAL),
+	local_size_(0)
 { }
 
 Value::Value(Value const& o)
 :
-	tag_(TAG_INVALID)
+	payload_(),
+	tag_(TAG_INVALID),
+	storage_(STORAGE_LOCAL),
+	local_size_(0)
 {
 	clone(o);
 }
 
-Value::Value(Value&& o)
+Value::Value(Value&& o) noexcept
 :
-	tag_(TAG_INVALID)
+	payload_(o.payload_),
+	tag_(o.tag_),
+	storage_(o.storage_),
+	local_size_(o.local_size_)
 {
-	*this = std::move(o);
+	o.tag_ = TAG_INVALID;
 }
 
 Value & Value::operator=(Value const& o)
 {
 	if (&o != this) {
-		clear();
-		clone(o);
+		// o might be owned by this
+		Value tmp(o);
+		*this = std::move(tmp);
 	}
 	return *this;
 }
 
-Value & Value::operator=(Value&& o)
+Value & Value::operator=(Value&& o) noexcept
 {
 	if (&o == this) {
 		return *this;
 	}
 
+	// take over the payload before clearing,
+	// o might be owned by this
+	Payload payload(o.payload_);
+	Tag tag(o.tag_);
+	uint8_t storage(o.storage_);
+	uint8_t local_size(o.local_size_);
+	o.tag_ = TAG_INVALID;
+
 	clear();
-	tag_ = o.tag_;
+	payload_ = payload;
+	tag_ = tag;
+	storage_ = storage;
+	local_size_ = local_size;
+	return *this;
+}
 
-	switch (tag_) {
+Value::~Value()
+{
+	clear();
+}
+
+void Value::clone(Value const& o)
+{
+	assert(&o != this);
+	assert(tag_ == TAG_INVALID);
+
+	switch (o.tag_) {
 	case TAG_INVALID:
 	case TAG_TRUE:
 	case TAG_FALSE:
 	case TAG_NULL:
-		break;
 	case TAG_NUMBER:
-		assert(o.number_);
-		number_ = std::move(o.number_);
+		payload_ = o.payload_;
 		break;
 	case TAG_STRING:
-		assert(o.string_);
-		string_ = std::move(o.string_);
+		if (o.storage_ == STORAGE_HEAP) {
+			counted_acquire(o.payload_.heap.data);
+			payload_ = o.payload_;
+			storage_ = STORAGE_HEAP;
+		} else if (o.storage_ == STORAGE_INTERNED) {
+			InternedKey::from(o.payload_.heap.data)->acquire();
+			payload_ = o.payload_;
+			storage_ = STORAGE_INTERNED;
+		} else {
+			assign(o.as_string());
+		}
 		break;
 	case TAG_OBJECT:
-		assert(o.object_);
-		object_ = std::move(o.object_);
+		if (o.storage_ == STORAGE_ARENA) {
+			payload_.object = counted_new<Object>(*o.payload_.object);
+		} else {
+			counted_acquire(o.payload_.object);
+			payload_.object = o.payload_.object;
+		}
 		break;
 	case TAG_ARRAY:
-		assert(o.array_);
-		array_ = std::move(o.array_);
+		if (o.storage_ == STORAGE_ARENA) {
+			payload_.array = counted_new<Array>(*o.payload_.array);
+		} else {
+			counted_acquire(o.payload_.array);
+			payload_.array = o.payload_.array;
+		}
 		break;
 	}
 
-	o.tag_ = TAG_INVALID;
-	return *this;
+	tag_ = o.tag_;
 }
 
-Value::~Value()
-{ }
-
-void Value::clone(Value const& o)
+void Value::clear()
 {
-	assert(&o != this);
-
-	tag_ = o.tag_;
-
 	switch (tag_) {
 	case TAG_INVALID:
 	case TAG_TRUE:
 	case TAG_FALSE:
 	case TAG_NULL:
-		break;
 	case TAG_NUMBER:
-		assert(o.number_);
-		number_.reset(new Number(*o.number_));
 		break;
 	case TAG_STRING:
-		assert(o.string_);
-		string_.reset(new String(*o.string_));
+		if (storage_ == STORAGE_HEAP) {
+			counted_release(payload_.heap.data);
+		} else if (storage_ == STORAGE_INTERNED) {
+			InternedKey::from(payload_.heap.data)->release();
+		}
 		break;
 	case TAG_OBJECT:
-		assert(o.object_);
-		object_.reset(new Object(*o.object_));
+		if (storage_ != STORAGE_ARENA) {
+			counted_release(payload_.object);
+		}
 		break;
 	case TAG_ARRAY:
-		assert(o.array_);
-		array_.reset(new Array(*o.array_));
+		if (storage_ != STORAGE_ARENA) {
+			counted_release(payload_.array);
+		}
 		break;
 	}
+
+	tag_ = TAG_INVALID;
+	storage_ = STORAGE_LOCAL;
 }
 
-void Value::clear()
+// does not set the tag, the caller has to
+void Value::assign(StringView str, Arena *arena)
 {
-	number_.reset();
-	string_.reset();
-	object_.reset();
-	object_.reset();
-	tag_ = TAG_INVALID;
+	if (str.size() <= sizeof(payload_.local)) {
+		storage_ = STORAGE_LOCAL;
+		local_size_ = str.size();
+		memcpy(payload_.local, str.data(), str.size());
+	} else if (arena) {
+		storage_ = STORAGE_ARENA;
+		payload_.heap.data = static_cast<char *>(arena->allocate(str.size(), 1));
+		payload_.heap.size = str.size();
+		memcpy(payload_.heap.data, str.data(), str.size());
+	} else {
+		storage_ = STORAGE_HEAP;
+		payload_.heap.data = counted_chars(str.size());
+		payload_.heap.size = str.size();
+		memcpy(payload_.heap.data, str.data(), str.size());
+	}
+}
+
+/*
+ * Nodes in an Arena are never destroyed, the Arena
+ * has to own everything reachable from them. Without
+ * an Arena the string goes to the heap.
+ */
+Value::Value(StringView str, Arena *arena)
+:
+	payload_(),
+	tag_(TAG_STRING),
+	storage_(STORAGE_LOCAL),
+	local_size_(0)
+{
+	assign(str, arena);
+}
+
+/*
+ * Long strings refer to the input of the parser,
+ * which has to outlive the Value.
+ */
+Value Value::borrow(StringView str)
+{
+	Value res;
+	if (str.size() <= sizeof(res.payload_.local)) {
+		res.assign(str);
+	} else {
+		res.storage_ = STORAGE_BORROWED;
+		res.payload_.heap.data = const_cast<char *>(str.data());
+		res.payload_.heap.size = str.size();
+	}
+	res.tag_ = TAG_STRING;
+	return res;
+}
+
+Value Value::interned(StringView key)
+{
+	Value res;
+	res.storage_ = STORAGE_INTERNED;
+	res.payload_.heap.data = const_cast<char *>(key.data());
+	res.payload_.heap.size = key.size();
+	res.tag_ = TAG_STRING;
+	return res;
+}
+
+Value::Value(Object && object, Arena & arena)
+:
+	payload_(),
+	tag_(TAG_OBJECT),
+	storage_(STORAGE_ARENA),
+	local_size_(0)
+{
+	void *p(arena.allocate(sizeof(Object), alignof(Object)));
+	payload_.object = new (p) Object(std::move(object));
+}
+
+Value::Value(Array && array, Arena & arena)
+:
+	payload_(),
+	tag_(TAG_ARRAY),
+	storage_(STORAGE_ARENA),
+	local_size_(0)
+{
+	void *p(arena.allocate(sizeof(Array), alignof(Array)));
+	payload_.array = new (p) Array(std::move(array));
 }
 
 Value::Value(Null const&)
 :
-	tag_(TAG_NULL)
+	payload_(),
+	tag_(TAG_NULL),
+	storage_(STORAGE_LOCAL),
+	local_size_(0)
 { }
 
 Value::Value(True const&)
 :
-	tag_(TAG_TRUE)
+	payload_(),
+	tag_(TAG_TRUE),
+	storage_(STORAGE_LOCAL),
+	local_size_(0)
 { }
 
 Value::Value(False const&)
 :
-	tag_(TAG_FALSE)
+	payload_(),
+	tag_(TAG_FALSE),
+	storage_(STORAGE_LOCAL),
+	local_size_(0)
 { }
 
 Value::Value(Number const& number)
 :
-	tag_(TAG_NUMBER)
+	payload_(),
+	tag_(TAG_NUMBER),
+	storage_(STORAGE_LOCAL),
+	local_size_(0)
 {
-	number_.reset(new Number(number));
+	payload_.number = number;
 }
 
 Value::Value(String const& string)
 :
-	tag_(TAG_STRING)
+	payload_(),
+	tag_(TAG_INVALID),
+	storage_(STORAGE_LOCAL),
+	local_size_(0)
 {
-	string_.reset(new String(string));
+	set(string);
 }
 
 Value::Value(Object const& object)
 :
-	tag_(TAG_OBJECT)
+	payload_(),
+	tag_(TAG_OBJECT),
+	storage_(STORAGE_LOCAL),
+	local_size_(0)
 {
-	object_.reset(new Object(object));
+	payload_.object = counted_new<Object>(object);
 }
 
 Value::Value(Array const& array)
 :
-	tag_(TAG_ARRAY)
+	payload_(),
+	tag_(TAG_ARRAY),
+	storage_(STORAGE_LOCAL),
+	local_size_(0)
 {
-	array_.reset(new Array(array));
+	payload_.array = counted_new<Array>(array);
+}
+
+Value::Value(String && string)
+:
+	payload_(),
+	tag_(TAG_INVALID),
+	storage_(STORAGE_LOCAL),
+	local_size_(0)
+{
+	set(string);
+}
+
+Value::Value(Object && object)
+:
+	payload_(),
+	tag_(TAG_OBJECT),
+	storage_(STORAGE_LOCAL),
+	local_size_(0)
+{
+	payload_.object = counted_new<Object>(std::move(object));
+}
+
+Value::Value(Array && array)
+:
+	payload_(),
+	tag_(TAG_ARRAY),
+	storage_(STORAGE_LOCAL),
+	local_size_(0)
+{
+	payload_.array = counted_new<Array>(std::move(array));
 }
 
 void Value::set(Null const&)
@@ -185,67 +364,76 @@ void Value::set(False const&)
 void Value::set(Number const& number)
 {
 	clear();
+	payload_.number = number;
 	tag_ = TAG_NUMBER;
-	number_.reset(new Number(number));
 }
 
 void Value::set(String const& string)
 {
 	clear();
+	assign(string.str());
 	tag_ = TAG_STRING;
-	string_.reset(new String(string));
 }
 
 void Value::set(Object const& object)
 {
+	set(Object(object));
+}
+
+void Value::set(Array const& array)
+{
+	set(Array(array));
+}
+
+void Value::set(String && string)
+{
+	set(static_cast<String const&>(string));
+}
+
+void Value::set(Object && object)
+{
+	auto *payload(counted_new<Object>(std::move(object)));
 	clear();
+	payload_.object = payload;
 	tag_ = TAG_OBJECT;
-	object_.reset(new Object(object));
 }
 
-void Value::set(Array const& array)
+void Value::set(Array && array)
 {
+	auto *payload(counted_new<Array>(std::move(array)));
 	clear();
+	payload_.array = payload;
 	tag_ = TAG_ARRAY;
-	array_.reset(new Array(array));
 }
 
 void Value::build(std::unique_ptr<Number> number)
 {
-	clear();
-	tag_ = TAG_NUMBER;
-	number_ = std::move(number);
+	set(*number);
 }
 
 void Value::build(std::unique_ptr<String> string)
 {
-	clear();
-	tag_ = TAG_STRING;
-	string_ = std::move(string);
+	set(*string);
 }
 
 void Value::build(std::unique_ptr<Object> object)
 {
-	clear();
-	tag_ = TAG_OBJECT;
-	object_ = std::move(object);
+	set(std::move(*object));
 }
 
 void Value::build(std::unique_ptr<Array> array)
 {
-	clear();
-	tag_ = TAG_ARRAY;
-	array_ = std::move(array);
+	set(std::move(*array));
 }
 
 void Value::make_object(std::initializer_list<Member> m)
 {
-	build(std::unique_ptr<Object>(new Object(std::move(m))));
+	set(Object(m));
 }
 
 void Value::make_array(std::initializer_list<Value> v)
 {
-	build(std::unique_ptr<Array>(new Array(std::move(v))));
+	set(Array(v));
 }
 
 Value::Tag Value::tag() const
@@ -274,29 +462,45 @@ False Value::false_value() const
 Number Value::number() const
 {
 	assert(tag_ == TAG_NUMBER);
-	assert(number_);
-	return *number_;
+	return payload_.number;
 }
 
 String Value::string() const
 {
-	assert(tag_ == TAG_STRING);
-	assert(string_);
-	return *string_;
+	return as_string().str();
 }
 
 Array Value::array() const
 {
-	assert(tag_ == TAG_ARRAY);
-	assert(array_);
-	return *array_;
+	return as_array();
 }
 
 Object Value::object() const
+{
+	return as_object();
+}
+
+StringView Value::as_string() const
+{
+	assert(tag_ == TAG_STRING);
+	if (storage_ == STORAGE_LOCAL) {
+		return StringView(payload_.local, local_size_);
+	}
+	return StringView(payload_.heap.data, payload_.heap.size);
+}
+
+Array const& Value::as_array() const
+{
+	assert(tag_ == TAG_ARRAY);
+	assert(payload_.array);
+	return *payload_.array;
+}
+
+Object const& Value::as_object() const
 {
 	assert(tag_ == TAG_OBJECT);
-	assert(object_);
-	return *object_;
+	assert(payload_.object);
+	return *payload_.object;
 }
 
 void ValueFactory<bool>::build(bool const& value, Value & res)
@@ -310,57 +514,57 @@ void ValueFactory<bool>::build(bool const& value, Value & res)
 
 void ValueFactory<uint8_t>::build(uint8_t const& value, Value & res)
 {
-	res.make<Number>(value);
+	res.set(Number(value));
 }
 
 void ValueFactory<int8_t>::build(int8_t const& value, Value & res)
 {
-	res.make<Number>(value);
+	res.set(Number(value));
 }
 
 void ValueFactory<uint16_t>::build(uint16_t const& value, Value & res)
 {
-	res.make<Number>(value);
+	res.set(Number(value));
 }
 
 void ValueFactory<int16_t>::build(int16_t const& value, Value & res)
 {
-	res.make<Number>(value);
+	res.set(Number(value));
 }
 
 void ValueFactory<uint32_t>::build(uint32_t const& value, Value & res)
 {
-	res.make<Number>(value);
+	res.set(Number(value));
 }
 
 void ValueFactory<int32_t>::build(int32_t const& value, Value & res)
 {
-	res.make<Number>(value);
+	res.set(Number(value));
 }
 
 void ValueFactory<uint64_t>::build(uint64_t const& value, Value & res)
 {
-	res.make<Number>(value);
+	res.set(Number(value));
 }
 
 void ValueFactory<int64_t>::build(int64_t const& value, Value & res)
 {
-	res.make<Number>(value);
+	res.set(Number(value));
 }
 
 void ValueFactory<float>::build(float const& value, Value & res)
 {
-	res.make<Number>(value);
+	res.set(Number(value));
 }
 
 void ValueFactory<double>::build(double const& value, Value & res)
 {
-	res.make<Number>(value);
+	res.set(Number(value));
 }
 
 void ValueFactory<long double>::build(long double const& value, Value & res)
 {
-	res.make<Number>(value);
+	res.set(Number(value));
 }
 
 }
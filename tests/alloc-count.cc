@@ -0,0 +1,35 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "alloc-count.h"
+
+namespace {
+
+std::atomic<size_t> allocations(0);
+
+}
+
+void *operator new(size_t size)
+{
+	++allocations;
+	void *res(malloc(size ? size : 1));
+	if (!res) {
+		throw std::bad_alloc();
+	}
+	return res;
+}
+
+void operator delete(void *ptr) noexcept
+{
+	free(ptr);
+}
+
+namespace unittests {
+
+size_t alloc_count()
+{
+	return allocations;
+}
+
+}
@@ -0,0 +1,13 @@
+#ifndef UNITTESTS_ALLOC_COUNT_H
+#define UNITTESTS_ALLOC_COUNT_H
+
+#include <cstddef>
+
+namespace unittests {
+
+// number of calls to the global operator new since program start
+size_t alloc_count();
+
+}
+
+#endif
@@ -27,6 +27,7 @@ private:
 	void test_vector_nested();
 	void test_list();
 	void test_set();
+	void test_as_elements();
 
 	CPPUNIT_TEST_SUITE(test);
 	CPPUNIT_TEST(test_empty);
@@ -42,6 +43,7 @@ private:
 	CPPUNIT_TEST(test_vector_nested);
 	CPPUNIT_TEST(test_list);
 	CPPUNIT_TEST(test_set);
+	CPPUNIT_TEST(test_as_elements);
 	CPPUNIT_TEST_SUITE_END();
 };
 
@@ -332,4 +334,19 @@ void test::test_set()
 	CPPUNIT_ASSERT_EQUAL(expected, ss.str());
 }
 
+void test::test_as_elements()
+{
+	Json::Array a{ "foo", 2, true };
+
+	Json::View<Json::Value> elements(a.as_elements());
+	CPPUNIT_ASSERT_EQUAL(size_t(3), elements.size());
+	CPPUNIT_ASSERT(elements[0].as_string() == "foo");
+	CPPUNIT_ASSERT_EQUAL(Json::Value(2), elements[1]);
+	CPPUNIT_ASSERT_EQUAL(Json::Value::TAG_TRUE, elements[2].tag());
+	CPPUNIT_ASSERT_EQUAL(&*a.begin(), elements.begin());
+	CPPUNIT_ASSERT_EQUAL(size_t(3), size_t(elements.end() - elements.begin()));
+
+	CPPUNIT_ASSERT(Json::Array().as_elements().empty());
+}
+
 }}}
@@ -2,6 +2,10 @@
 
 #include <jsoncc.h>
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 namespace unittests {
 namespace eqality {
 
@@ -19,6 +23,7 @@ private:
 	void test_string();
 	void test_array();
 	void test_object();
+	void test_large_object();
 	void test_value();
 
 	CPPUNIT_TEST_SUITE(test);
@@ -29,6 +34,7 @@ private:
 	CPPUNIT_TEST(test_string);
 	CPPUNIT_TEST(test_array);
 	CPPUNIT_TEST(test_object);
+	CPPUNIT_TEST(test_large_object);
 	CPPUNIT_TEST(test_value);
 	CPPUNIT_TEST_SUITE_END();
 };
@@ -139,6 +145,62 @@ void test::test_object()
 	CPPUNIT_ASSERT(!Json::equal(o7, o8));
 }
 
+Json::Object make_object(std::vector<Json::Member> const& members)
+{
+	Json::Object res;
+	for (auto const& member : members) {
+		res << member;
+	}
+	return res;
+}
+
+void test::test_large_object()
+{
+	std::vector<Json::Member> members;
+	for (int i(0); i < 1000; ++i) {
+		// keys which are prefixes of others
+		members.emplace_back(std::string(i % 7 + 1, 'k') + std::to_string(i / 7), i);
+	}
+	Json::Object object(make_object(members));
+
+	std::vector<Json::Member> reversed(members.rbegin(), members.rend());
+	CPPUNIT_ASSERT(Json::equal(object, make_object(reversed)));
+	CPPUNIT_ASSERT(Json::equal(Json::Value(object), Json::Value(make_object(reversed))));
+
+	// only the tail differs in order
+	std::vector<Json::Member> tail(members);
+	std::reverse(tail.begin() + 900, tail.end());
+	CPPUNIT_ASSERT(Json::equal(object, make_object(tail)));
+
+	reversed[500] = Json::Member(reversed[500].key().value(), -1);
+	CPPUNIT_ASSERT(!Json::equal(object, make_object(reversed)));
+	reversed[500] = Json::Member("unknown", 1);
+	CPPUNIT_ASSERT(!Json::equal(object, make_object(reversed)));
+
+	// duplicate keys, their values in any order
+	std::vector<Json::Member> dups(members);
+	dups.emplace_back("dup", 1);
+	dups.emplace_back("dup", 2);
+	dups.emplace_back("dup", 1);
+	std::vector<Json::Member> other_dups(dups.rbegin(), dups.rend());
+	CPPUNIT_ASSERT(Json::equal(make_object(dups), make_object(other_dups)));
+
+	other_dups[0] = Json::Member("dup", 2);
+	CPPUNIT_ASSERT(!Json::equal(make_object(dups), make_object(other_dups)));
+
+	// same size, different numbers of duplicates
+	std::vector<Json::Member> more_dups(members);
+	more_dups.emplace_back("dup", 1);
+	more_dups.emplace_back("dup", 1);
+	more_dups.emplace_back("eek", 1);
+	std::vector<Json::Member> fewer_dups(members);
+	fewer_dups.emplace_back("dup", 1);
+	fewer_dups.emplace_back("eek", 1);
+	fewer_dups.emplace_back("eek", 1);
+	std::reverse(fewer_dups.begin(), fewer_dups.end());
+	CPPUNIT_ASSERT(!Json::equal(make_object(more_dups), make_object(fewer_dups)));
+}
+
 void test::test_value()
 {
 	CPPUNIT_ASSERT(Json::equal(Json::Value(), Json::Value()));
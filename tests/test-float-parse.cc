@@ -0,0 +1,169 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "float-parse.h"
+
+namespace unittests {
+namespace float_parse {
+
+class test : public CppUnit::TestCase {
+public:
+	test();
+	void setUp();
+	void tearDown();
+
+private:
+	void test_simple();
+	void test_limits();
+	void test_random_doubles();
+	void test_random_digits();
+	void test_halfway();
+
+	CPPUNIT_TEST_SUITE(test);
+	CPPUNIT_TEST(test_simple);
+	CPPUNIT_TEST(test_limits);
+	CPPUNIT_TEST(test_random_doubles);
+	CPPUNIT_TEST(test_random_digits);
+	CPPUNIT_TEST(test_halfway);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test);
+
+test::test()
+{ }
+
+void test::setUp()
+{ }
+
+void test::tearDown()
+{ }
+
+class Random {
+public:
+	Random() : state_(0x9e3779b97f4a7c15ULL) { }
+
+	uint64_t next()
+	{
+		// xorshift64*
+		state_ ^= state_ >> 12;
+		state_ ^= state_ << 25;
+		state_ ^= state_ >> 27;
+		return state_ * 0x2545f4914f6cdd1dULL;
+	}
+
+	size_t next(size_t n)
+	{
+		return next() % n;
+	}
+
+private:
+	uint64_t state_;
+};
+
+// compare bit by bit with strtod in the C locale
+void check(std::string const& str)
+{
+	double expected(strtod(str.c_str(), nullptr));
+	double actual;
+	bool ok(Json::parse_double(str.data(), str.data() + str.size(), actual));
+	if (std::isinf(expected)) {
+		CPPUNIT_ASSERT_MESSAGE(str, !ok);
+		return;
+	}
+
+	CPPUNIT_ASSERT_MESSAGE(str, ok);
+	CPPUNIT_ASSERT_MESSAGE(str, memcmp(&expected, &actual, sizeof(double)) == 0);
+}
+
+void test::test_simple()
+{
+	for (auto str: {"0", "-0", "0.0", "-0.0", "1", "-1", "1.5", "0.1", "0.3",
+		"1e0", "1E+2", "1e-2", "123456789012345678", "1.7976931348623157e308",
+		"2.2250738585072014e-308", "4.9406564584124654e-324", "5e-324",
+		"2.4703282292062327e-324", "2.4703282292062328e-324", "9007199254740993",
+		"0.000001", "100000000000000000000000", "1e23", "8.41e21",
+		"0.1000000000000000055511151231257827021181583404541015625",
+		"3.14159265358979323846264338327950288419716939937510"}) {
+		check(str);
+	}
+}
+
+void test::test_limits()
+{
+	check("1e308");
+	check("1e309");
+	check("-1e309");
+	check("1.7976931348623158e308");
+	check("1.7976931348623159e308");
+	check("1e-324");
+	check("1e-400");
+	check("-1e-400");
+	check("1e-100000000000");
+	check("0e-100000000000");
+	check("1e100000000000");
+	check("0e100000000000");
+	check(std::string("1") + std::string(400, '0'));
+	check(std::string("0.") + std::string(400, '0') + "1");
+	check(std::string("1.") + std::string(400, '0') + "1e-20");
+}
+
+void test::test_random_doubles()
+{
+	Random random;
+	char buf[64];
+	for (size_t i(0); i < 100000; ++i) {
+		uint64_t bits(random.next());
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		if (!std::isfinite(value)) {
+			continue;
+		}
+		snprintf(buf, sizeof(buf), "%.*g", int(1 + random.next(17)), value);
+		check(buf);
+	}
+}
+
+void test::test_random_digits()
+{
+	Random random;
+	for (size_t i(0); i < 100000; ++i) {
+		std::string str(random.next(2) ? "-" : "");
+		size_t digits(1 + random.next(i % 2 ? 19 : 40));
+		str += char('1' + random.next(9));
+		for (size_t d(1); d < digits; ++d) {
+			str += char('0' + random.next(10));
+		}
+		if (random.next(2)) {
+			str.insert(str.size() - random.next(digits), ".");
+			if (str.back() == '.' || str[str.size() - digits - 1] == '.') {
+				str += "0";
+			}
+		}
+		str += "e" + std::to_string(int(random.next(700)) - 350);
+		check(str);
+	}
+}
+
+void test::test_halfway()
+{
+	// exact decimal values in the middle between two doubles
+	Random random;
+	char buf[1200];
+	for (size_t i(0); i < 20000; ++i) {
+		uint64_t bits(random.next() & 0x7fefffffffffffffULL);
+		double lower;
+		memcpy(&lower, &bits, sizeof(lower));
+		long double mid((static_cast<long double>(lower) +
+			std::nextafter(lower, INFINITY)) / 2);
+		snprintf(buf, sizeof(buf), "%.*Le", int(17 + random.next(30)), mid);
+		check(buf);
+	}
+}
+
+}}
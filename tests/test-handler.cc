@@ -0,0 +1,204 @@
+#include <sstream>
+#include <string>
+
+#include <jsoncc-cppunit.h>
+#include "alloc-count.h"
+#include "error-assert.h"
+#include "error-io.h"
+
+namespace unittests {
+namespace handler {
+
+class test : public CppUnit::TestCase {
+public:
+	test();
+	void setUp();
+	void tearDown();
+
+private:
+	void test_empty_document();
+	void test_scalars();
+	void test_nested();
+	void test_empty_containers();
+	void test_bad_token();
+	void test_empty_name();
+	void test_max_depth();
+	void test_no_throw();
+	void test_no_tree();
+
+	CPPUNIT_TEST_SUITE(test);
+	CPPUNIT_TEST(test_empty_document);
+	CPPUNIT_TEST(test_scalars);
+	CPPUNIT_TEST(test_nested);
+	CPPUNIT_TEST(test_empty_containers);
+	CPPUNIT_TEST(test_bad_token);
+	CPPUNIT_TEST(test_empty_name);
+	CPPUNIT_TEST(test_max_depth);
+	CPPUNIT_TEST(test_no_throw);
+	CPPUNIT_TEST(test_no_tree);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test);
+
+// records all events as text
+class Recorder : public Json::Handler {
+public:
+	void null() override { os << "null "; }
+	void boolean(bool v) override { os << (v ? "true " : "false "); }
+	void number(int64_t v) override { os << "int:" << v << " "; }
+	void number(double v) override { os << "double:" << v << " "; }
+	void string(Json::StringView v) override { os << "string:" << v.str() << " "; }
+	void start_array() override { os << "[ "; }
+	void end_array() override { os << "] "; }
+	void start_object() override { os << "{ "; }
+	void key(Json::StringView v) override { os << "key:" << v.str() << " "; }
+	void end_object() override { os << "} "; }
+
+	std::stringstream os;
+};
+
+// counts events without allocating
+class Counter : public Json::Handler {
+public:
+	Counter() : events(0) { }
+
+	void null() override { ++events; }
+	void boolean(bool) override { ++events; }
+	void number(int64_t) override { ++events; }
+	void number(double) override { ++events; }
+	void string(Json::StringView) override { ++events; }
+	void start_array() override { ++events; }
+	void end_array() override { ++events; }
+	void start_object() override { ++events; }
+	void key(Json::StringView) override { ++events; }
+	void end_object() override { ++events; }
+
+	size_t events;
+};
+
+std::string record(std::string const& data)
+{
+	Json::Parser parser;
+	Recorder recorder;
+	parser.parse(data.data(), data.size(), recorder);
+	return recorder.os.str();
+}
+
+test::test()
+{ }
+
+void test::setUp()
+{ }
+
+void test::tearDown()
+{ }
+
+void test::test_empty_document()
+{
+	CPPUNIT_ASSERT_EQUAL(std::string(), record(""));
+	CPPUNIT_ASSERT_EQUAL(std::string(), record(" \n"));
+}
+
+void test::test_scalars()
+{
+	CPPUNIT_ASSERT_EQUAL(
+		std::string("[ true false null int:-42 double:0.5 string:h\xc3\xa4llo ] "),
+		record("[true, false, null, -42, 0.5, \"h\\u00e4llo\"]"));
+}
+
+void test::test_nested()
+{
+	CPPUNIT_ASSERT_EQUAL(
+		std::string("{ key:a [ int:1 { key:b null } ] key:c { key:d [ ] } } "),
+		record("{\"a\": [1, {\"b\": null}], \"c\": {\"d\": []}}"));
+}
+
+void test::test_empty_containers()
+{
+	CPPUNIT_ASSERT_EQUAL(std::string("[ ] "), record("[]"));
+	CPPUNIT_ASSERT_EQUAL(std::string("{ } "), record("{}"));
+	CPPUNIT_ASSERT_EQUAL(std::string("[ [ ] { } ] "), record("[[], {}]"));
+}
+
+void test::test_bad_token()
+{
+	Json::Parser parser;
+	Recorder recorder;
+
+	std::string data("[1, 2 3]");
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(
+		parser.parse(data.data(), data.size(), recorder), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::BAD_TOKEN_ARRAY_VALUE, error.type);
+	CPPUNIT_ASSERT_EQUAL(std::string("[ int:1 int:2 "), recorder.os.str());
+
+	data = "[] []";
+	CPPUNIT_ASSERT_THROW_VAR(
+		parser.parse(data.data(), data.size(), recorder), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::BAD_TOKEN_DOCUMENT, error.type);
+}
+
+void test::test_empty_name()
+{
+	Json::Parser parser;
+	Recorder recorder;
+
+	std::string data("{\"\": 1}");
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(
+		parser.parse(data.data(), data.size(), recorder), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::EMPTY_NAME, error.type);
+}
+
+void test::test_max_depth()
+{
+	Json::Parser parser;
+	parser.set_max_depth(2);
+	Recorder recorder;
+
+	std::string data("[[[]]]");
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(
+		parser.parse(data.data(), data.size(), recorder), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::PARSER_OVERFLOW, error.type);
+	CPPUNIT_ASSERT_EQUAL(std::string("[ [ "), recorder.os.str());
+}
+
+void test::test_no_throw()
+{
+	Json::Parser parser;
+	Recorder recorder;
+
+	std::string data("{\"a\" 1}");
+	Json::Error error;
+	parser.parse(data.data(), data.size(), recorder, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::BAD_TOKEN_OBJECT_NAME, error.type);
+
+	error = Json::Error();
+	data = "{\"a\": 1}";
+	parser.parse(data.data(), data.size(), recorder, error);
+	CPPUNIT_ASSERT(!error);
+}
+
+void test::test_no_tree()
+{
+	std::string data("[");
+	for (size_t i(0); i < 100; ++i) {
+		data += "{\"id\": 1, \"ratio\": 0.5, \"on\": true, \"tags\": [null, \"x\"]},";
+	}
+	data += "{}]";
+
+	Json::Parser parser;
+	Counter counter;
+	parser.parse(data.data(), data.size(), counter);
+
+	size_t before(unittests::alloc_count());
+	parser.parse(data.data(), data.size(), counter);
+	size_t after(unittests::alloc_count());
+
+	CPPUNIT_ASSERT_EQUAL(size_t(2 * (2 + 100 * 13 + 2)), counter.events);
+	CPPUNIT_ASSERT_EQUAL(size_t(0), after - before);
+}
+
+}}
@@ -0,0 +1,200 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <jsoncc-cppunit.h>
+
+namespace unittests {
+namespace hash {
+
+class test : public CppUnit::TestCase {
+public:
+	test();
+	void setUp();
+	void tearDown();
+
+private:
+	void test_scalars();
+	void test_strings();
+	void test_member_order();
+	void test_different_values();
+	void test_parsed_trees();
+	void test_cache();
+	void test_unordered_map();
+
+	CPPUNIT_TEST_SUITE(test);
+	CPPUNIT_TEST(test_scalars);
+	CPPUNIT_TEST(test_strings);
+	CPPUNIT_TEST(test_member_order);
+	CPPUNIT_TEST(test_different_values);
+	CPPUNIT_TEST(test_parsed_trees);
+	CPPUNIT_TEST(test_cache);
+	CPPUNIT_TEST(test_unordered_map);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test);
+
+test::test()
+{ }
+
+void test::setUp()
+{ }
+
+void test::tearDown()
+{ }
+
+void assert_same_hash(Json::Value const& l, Json::Value const& r)
+{
+	CPPUNIT_ASSERT(Json::equal(l, r));
+	CPPUNIT_ASSERT_EQUAL(Json::hash(l), Json::hash(r));
+}
+
+void test::test_scalars()
+{
+	assert_same_hash(Json::Value(), Json::Value());
+	assert_same_hash(Json::Null(), Json::Null());
+	assert_same_hash(true, true);
+	assert_same_hash(false, false);
+	assert_same_hash(Json::Number(), Json::Number());
+	assert_same_hash(int64_t(-5), int32_t(-5));
+	assert_same_hash(uint64_t(5), uint8_t(5));
+	assert_same_hash(0.0, -0.0);
+	assert_same_hash(1.5, 1.5f);
+}
+
+void test::test_strings()
+{
+	std::set<size_t> hashes;
+	for (size_t len(0); len < 100; ++len) {
+		std::string str(len, 'x');
+		for (size_t i(0); i < len; ++i) {
+			str[i] = 'a' + (i * 7) % 26;
+		}
+
+		assert_same_hash(Json::String(str), Json::String(str));
+		hashes.insert(Json::hash(Json::String(str)));
+	}
+	CPPUNIT_ASSERT_EQUAL(size_t(100), hashes.size());
+
+	// a change in any lane of a long string
+	std::string base(70, 'a');
+	for (size_t i(0); i < base.size(); ++i) {
+		std::string changed(base);
+		changed[i] = 'b';
+		CPPUNIT_ASSERT(Json::hash(Json::String(base)) != Json::hash(Json::String(changed)));
+	}
+}
+
+void test::test_member_order()
+{
+	assert_same_hash(
+		Json::Object{{"a", 1}, {"b", Json::Array{1, 2}}, {"c", Json::Object{{"d", true}}}},
+		Json::Object{{"c", Json::Object{{"d", true}}}, {"a", 1}, {"b", Json::Array{1, 2}}});
+
+	// duplicate keys
+	assert_same_hash(
+		Json::Object{{"a", 1}, {"a", 2}, {"a", 1}},
+		Json::Object{{"a", 2}, {"a", 1}, {"a", 1}});
+}
+
+void test::test_different_values()
+{
+	std::vector<Json::Value> values{
+		Json::Value(),
+		Json::Null(),
+		true,
+		false,
+		Json::Number(),
+		0,
+		uint64_t(0),
+		0.0,
+		1,
+		"",
+		"0",
+		Json::Array{},
+		Json::Object{},
+		Json::Array{1, 2},
+		Json::Array{2, 1},
+		Json::Array{Json::Array{1}, 2},
+		Json::Array{1, Json::Array{2}},
+		Json::Object{{"a", 1}, {"b", 2}},
+		Json::Object{{"a", 2}, {"b", 1}},
+		Json::Object{{"a", 1}},
+		Json::Object{{"a", 1}, {"a", 1}},
+	};
+
+	std::set<size_t> hashes;
+	for (auto const& value : values) {
+		hashes.insert(Json::hash(value));
+	}
+	CPPUNIT_ASSERT_EQUAL(values.size(), hashes.size());
+}
+
+void test::test_parsed_trees()
+{
+	std::string text("{\"a rather long key for the heap\": [1, -2, 3.5, \"a string "
+		"long enough for the heap\"], \"k\": {\"x\": null}}");
+	std::string reordered("{\"k\": {\"x\": null}, \"a rather long key for the heap\": "
+		"[1, -2, 3.5, \"a string long enough for the heap\"]}");
+
+	Json::Parser parser;
+	Json::Value value(parser.parse(text.data(), text.size()));
+	Json::Document doc;
+	parser.parse(text.data(), text.size(), doc);
+	Json::Document borrowed;
+	parser.parse_borrowed(reordered.data(), reordered.size(), borrowed);
+
+	Json::KeyTable table;
+	parser.set_key_table(&table);
+	Json::Value interned(parser.parse(text.data(), text.size()));
+
+	assert_same_hash(value, doc.root());
+	assert_same_hash(value, borrowed.root());
+	assert_same_hash(value, interned);
+}
+
+void test::test_cache()
+{
+	Json::Value value(Json::Object{{"list", Json::Array{1, 2, 3}}, {"b", true}});
+	size_t expected(Json::hash(value));
+	CPPUNIT_ASSERT_EQUAL(expected, Json::hash(value, true));
+	CPPUNIT_ASSERT_EQUAL(expected, Json::hash(value));
+
+	// copies keep the hash, changes drop it
+	Json::Object changed(value.object());
+	CPPUNIT_ASSERT_EQUAL(expected, Json::hash(Json::Value(changed)));
+	changed << Json::Member("c", 1);
+	Json::Value other(changed);
+	CPPUNIT_ASSERT(expected != Json::hash(other, true));
+	CPPUNIT_ASSERT_EQUAL(Json::hash(Json::Object{{"c", 1}, {"b", true},
+		{"list", Json::Array{1, 2, 3}}}), Json::hash(other));
+
+	// known hashes tell containers apart early
+	Json::Value same(Json::Object{{"b", true}, {"list", Json::Array{1, 2, 3}}});
+	Json::Value different(Json::Object{{"b", true}, {"list", Json::Array{1, 2, 4}}});
+	Json::hash(same, true);
+	Json::hash(different, true);
+	CPPUNIT_ASSERT(Json::equal(value, same));
+	CPPUNIT_ASSERT(!Json::equal(value, different));
+}
+
+void test::test_unordered_map()
+{
+	std::unordered_map<Json::Value, size_t, Json::ValueHash, Json::ValueEqual> counts;
+	++counts[Json::Object{{"a", 1}, {"b", 2}}];
+	++counts[Json::Object{{"b", 2}, {"a", 1}}];
+	++counts[Json::Array{1, 2}];
+	++counts[Json::Value("a")];
+
+	CPPUNIT_ASSERT_EQUAL(size_t(3), counts.size());
+	Json::Value object(Json::Object{{"a", 1}, {"b", 2}});
+	Json::Value array(Json::Array{1, 2});
+	CPPUNIT_ASSERT_EQUAL(size_t(2), counts[object]);
+	CPPUNIT_ASSERT_EQUAL(size_t(1), counts[array]);
+}
+
+}}
@@ -19,6 +19,7 @@ private:
 	void test_number();
 	void test_number_conversions();
 	void test_string();
+	void test_string_view();
 
 	CPPUNIT_TEST_SUITE(test);
 	CPPUNIT_TEST(test_null);
@@ -27,6 +28,7 @@ private:
 	CPPUNIT_TEST(test_number);
 	CPPUNIT_TEST(test_number_conversions);
 	CPPUNIT_TEST(test_string);
+	CPPUNIT_TEST(test_string_view);
 	CPPUNIT_TEST_SUITE_END();
 };
 
@@ -217,4 +219,22 @@ void test::test_string()
 	CPPUNIT_ASSERT_EQUAL(s, s1);
 }
 
+void test::test_string_view()
+{
+	Json::String s("Hello");
+	CPPUNIT_ASSERT_EQUAL(std::string("Hello"), s.str());
+	CPPUNIT_ASSERT_EQUAL(&s.str(), &s.str());
+
+	Json::StringView v(s.str());
+	CPPUNIT_ASSERT_EQUAL(s.str().data(), v.data());
+	CPPUNIT_ASSERT_EQUAL(size_t(5), v.size());
+	CPPUNIT_ASSERT(v == "Hello");
+	CPPUNIT_ASSERT(v != "Hell");
+	CPPUNIT_ASSERT(v != "Hello!");
+	CPPUNIT_ASSERT(Json::StringView("Hello world", 5) == v);
+	CPPUNIT_ASSERT(Json::StringView().empty());
+	CPPUNIT_ASSERT(Json::StringView() == "");
+	CPPUNIT_ASSERT_EQUAL(std::string("Hello"), std::string(v.begin(), v.end()));
+}
+
 }}
@@ -0,0 +1,227 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <jsoncc-cppunit.h>
+
+namespace unittests {
+namespace key_table {
+
+class test : public CppUnit::TestCase {
+public:
+	test();
+	void setUp();
+	void tearDown();
+
+private:
+	void test_shared_keys();
+	void test_short_keys();
+	void test_outlives_table();
+	void test_document();
+	void test_borrowed();
+	void test_unset();
+	void test_threads();
+	void test_ndjson();
+
+	CPPUNIT_TEST_SUITE(test);
+	CPPUNIT_TEST(test_shared_keys);
+	CPPUNIT_TEST(test_short_keys);
+	CPPUNIT_TEST(test_outlives_table);
+	CPPUNIT_TEST(test_document);
+	CPPUNIT_TEST(test_borrowed);
+	CPPUNIT_TEST(test_unset);
+	CPPUNIT_TEST(test_threads);
+	CPPUNIT_TEST(test_ndjson);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test);
+
+test::test()
+{ }
+
+void test::setUp()
+{ }
+
+void test::tearDown()
+{ }
+
+const std::string record("{\"a_rather_long_key_name\": 1, \"short\": 2, "
+	"\"another_long_key_name\": {\"a_rather_long_key_name\": 3}}");
+
+Json::Value parse(Json::Parser & parser, std::string const& text)
+{
+	return parser.parse(text.data(), text.size());
+}
+
+Json::Value const& member(Json::Value const& value, Json::StringView key)
+{
+	return value.as_object().as_member(key);
+}
+
+char const *key_data(Json::Value const& value, size_t pos)
+{
+	return value.as_object().as_members()[pos].as_key().data();
+}
+
+void test::test_shared_keys()
+{
+	Json::KeyTable table;
+	Json::Parser parser;
+	parser.set_key_table(&table);
+
+	Json::Value first(parse(parser, record));
+	Json::Value second(parse(parser, record));
+	CPPUNIT_ASSERT_EQUAL(first, second);
+	CPPUNIT_ASSERT_EQUAL(size_t(2), table.size());
+	CPPUNIT_ASSERT_EQUAL(size_t(4), parser.key_stats().hits);
+	CPPUNIT_ASSERT_EQUAL(size_t(2), parser.key_stats().misses);
+
+	CPPUNIT_ASSERT(key_data(first, 0) == key_data(second, 0));
+	CPPUNIT_ASSERT(key_data(first, 2) == key_data(second, 2));
+	CPPUNIT_ASSERT(key_data(first, 0) == key_data(member(first, "another_long_key_name"), 0));
+	CPPUNIT_ASSERT_EQUAL(Json::Value(3),
+		member(member(first, "another_long_key_name"), "a_rather_long_key_name"));
+
+	// copies share the key as well
+	Json::Value copy(first);
+	CPPUNIT_ASSERT(key_data(first, 0) == key_data(copy, 0));
+}
+
+void test::test_short_keys()
+{
+	Json::KeyTable table;
+	Json::Parser parser;
+	parser.set_key_table(&table);
+
+	Json::Value value(parse(parser, "{\"short\": 1, \"sixteen_chars___\": 2}"));
+	CPPUNIT_ASSERT_EQUAL(Json::Value(2), member(value, "sixteen_chars___"));
+	CPPUNIT_ASSERT_EQUAL(size_t(0), table.size());
+	CPPUNIT_ASSERT_EQUAL(size_t(0), parser.key_stats().hits);
+	CPPUNIT_ASSERT_EQUAL(size_t(0), parser.key_stats().misses);
+}
+
+void test::test_outlives_table()
+{
+	Json::Value value;
+	{
+		Json::KeyTable table;
+		Json::Parser parser;
+		parser.set_key_table(&table);
+		value = parse(parser, record);
+	}
+
+	Json::Value copy(value);
+	value = Json::Value();
+	CPPUNIT_ASSERT_EQUAL(Json::Value(1), member(copy, "a_rather_long_key_name"));
+	CPPUNIT_ASSERT_EQUAL(std::string("another_long_key_name"),
+		copy.as_object().as_members()[2].as_key().str());
+}
+
+void test::test_document()
+{
+	Json::Document doc;
+	Json::Document other;
+	{
+		Json::KeyTable table;
+		Json::Parser parser;
+		parser.set_key_table(&table);
+		parser.parse(record.data(), record.size(), doc);
+		parser.parse(record.data(), record.size(), other);
+		CPPUNIT_ASSERT_EQUAL(size_t(2), table.size());
+	}
+
+	// the documents keep the table
+	CPPUNIT_ASSERT(key_data(doc.root(), 0) == key_data(other.root(), 0));
+	CPPUNIT_ASSERT_EQUAL(Json::Value(3),
+		member(member(doc.root(), "another_long_key_name"), "a_rather_long_key_name"));
+
+	Json::Document moved(std::move(doc));
+	other = Json::Document();
+	CPPUNIT_ASSERT_EQUAL(Json::Value(1), member(moved.root(), "a_rather_long_key_name"));
+}
+
+void test::test_borrowed()
+{
+	Json::KeyTable table;
+	Json::Parser parser;
+	parser.set_key_table(&table);
+
+	Json::Document doc;
+	parser.parse_borrowed(record.data(), record.size(), doc);
+	CPPUNIT_ASSERT(key_data(doc.root(), 0) == record.data() + 2);
+	CPPUNIT_ASSERT_EQUAL(size_t(0), table.size());
+}
+
+void test::test_unset()
+{
+	Json::KeyTable table;
+	Json::Parser parser;
+	parser.set_key_table(&table);
+	parse(parser, record);
+
+	parser.set_key_table(nullptr);
+	CPPUNIT_ASSERT_EQUAL(size_t(0), parser.key_stats().misses);
+
+	Json::Value value(parse(parser, record));
+	CPPUNIT_ASSERT_EQUAL(size_t(0), parser.key_stats().hits);
+	CPPUNIT_ASSERT_EQUAL(size_t(2), table.size());
+	CPPUNIT_ASSERT_EQUAL(Json::Value(1), member(value, "a_rather_long_key_name"));
+}
+
+void test::test_threads()
+{
+	Json::KeyTable table;
+	std::vector<Json::Value> values(4);
+	std::vector<std::thread> threads;
+	for (auto & value : values) {
+		threads.emplace_back([&table, &value] {
+			Json::Parser parser;
+			parser.set_key_table(&table);
+			std::string text("{");
+			for (size_t i(0); i < 200; ++i) {
+				text += "\"a_rather_long_key_" + std::to_string(i) + "\": 1, ";
+			}
+			text += "\"a_rather_long_key_0\": 2}";
+			for (size_t i(0); i < 20; ++i) {
+				value = parse(parser, text);
+			}
+		});
+	}
+	for (auto & thread : threads) {
+		thread.join();
+	}
+
+	CPPUNIT_ASSERT_EQUAL(size_t(200), table.size());
+	for (auto & value : values) {
+		CPPUNIT_ASSERT(key_data(value, 7) == key_data(values[0], 7));
+		CPPUNIT_ASSERT(key_data(value, 200) == key_data(value, 0));
+	}
+}
+
+void test::test_ndjson()
+{
+	std::string data;
+	for (size_t i(0); i < 1000; ++i) {
+		data += record + "\n";
+	}
+
+	Json::KeyTable table;
+	Json::NdjsonParser parser(4);
+	parser.set_key_table(&table);
+
+	std::vector<Json::Value> values;
+	parser.parse(data.data(), data.size(), [&values](Json::NdjsonParser::Record & line) {
+		values.push_back(std::move(line.value));
+	});
+
+	CPPUNIT_ASSERT_EQUAL(size_t(1000), values.size());
+	CPPUNIT_ASSERT_EQUAL(size_t(2), table.size());
+	CPPUNIT_ASSERT_EQUAL(size_t(2998), parser.key_stats().hits);
+	CPPUNIT_ASSERT_EQUAL(size_t(2), parser.key_stats().misses);
+	CPPUNIT_ASSERT(key_data(values.front(), 0) == key_data(values.back(), 0));
+}
+
+}}
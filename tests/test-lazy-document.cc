@@ -0,0 +1,223 @@
+#include <string>
+
+#include <jsoncc-cppunit.h>
+#include "error-assert.h"
+#include "error-io.h"
+
+namespace unittests {
+namespace lazy_document {
+
+class test : public CppUnit::TestCase {
+public:
+	test();
+	void setUp();
+	void tearDown();
+
+private:
+	void test_empty_document();
+	void test_member_lookup();
+	void test_element_lookup();
+	void test_skip_nested();
+	void test_escaped_keys();
+	void test_missing();
+	void test_tags();
+	void test_getters();
+	void test_type_mismatch();
+	void test_value();
+	void test_bad_document();
+	void test_reuse();
+
+	CPPUNIT_TEST_SUITE(test);
+	CPPUNIT_TEST(test_empty_document);
+	CPPUNIT_TEST(test_member_lookup);
+	CPPUNIT_TEST(test_element_lookup);
+	CPPUNIT_TEST(test_skip_nested);
+	CPPUNIT_TEST(test_escaped_keys);
+	CPPUNIT_TEST(test_missing);
+	CPPUNIT_TEST(test_tags);
+	CPPUNIT_TEST(test_getters);
+	CPPUNIT_TEST(test_type_mismatch);
+	CPPUNIT_TEST(test_value);
+	CPPUNIT_TEST(test_bad_document);
+	CPPUNIT_TEST(test_reuse);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test);
+
+void parse(Json::LazyDocument & doc, std::string const& data)
+{
+	Json::Parser parser;
+	parser.parse(data.data(), data.size(), doc);
+}
+
+test::test()
+{ }
+
+void test::setUp()
+{ }
+
+void test::tearDown()
+{ }
+
+void test::test_empty_document()
+{
+	Json::LazyDocument doc;
+	parse(doc, " ");
+	CPPUNIT_ASSERT(!doc.root());
+	CPPUNIT_ASSERT(!doc["key"]);
+}
+
+void test::test_member_lookup()
+{
+	std::string data("{\"user\": {\"name\": \"alice\", \"id\": 42}, \"id\": 7}");
+	Json::LazyDocument doc;
+	parse(doc, data);
+
+	CPPUNIT_ASSERT_EQUAL(int64_t(42), doc["user"]["id"].get_int64());
+	CPPUNIT_ASSERT_EQUAL(int64_t(7), doc["id"].get_int64());
+	CPPUNIT_ASSERT_EQUAL(std::string("alice"), doc["user"]["name"].get_string());
+}
+
+void test::test_element_lookup()
+{
+	std::string data(" [ 1 , [2, 3] ,{\"a\": [4]}, \"five\" ] ");
+	Json::LazyDocument doc;
+	parse(doc, data);
+
+	CPPUNIT_ASSERT_EQUAL(int64_t(1), doc[0].get_int64());
+	CPPUNIT_ASSERT_EQUAL(int64_t(3), doc[1][1].get_int64());
+	CPPUNIT_ASSERT_EQUAL(int64_t(4), doc[2]["a"][0].get_int64());
+	CPPUNIT_ASSERT_EQUAL(std::string("five"), doc[3].get_string());
+	CPPUNIT_ASSERT(!doc[4]);
+}
+
+void test::test_skip_nested()
+{
+	std::string data("{\"skip\": [{\"x\": \"]}\"}, [[]], {\"y\": {}}], "
+		"\"also\": {\"a\": [1, {\"b\": \"[\"}]}, \"target\": [[], {\"t\": true}]}");
+	Json::LazyDocument doc;
+	parse(doc, data);
+
+	CPPUNIT_ASSERT_EQUAL(true, doc["target"][1]["t"].get_bool());
+	CPPUNIT_ASSERT_EQUAL(std::string("["), doc["also"]["a"][1]["b"].get_string());
+	CPPUNIT_ASSERT_EQUAL(std::string("]}"), doc["skip"][0]["x"].get_string());
+}
+
+void test::test_escaped_keys()
+{
+	std::string data("{\"a\\\"b\": 1, \"\\u00e4\": 2, \"\\\\\": 3}");
+	Json::LazyDocument doc;
+	parse(doc, data);
+
+	CPPUNIT_ASSERT_EQUAL(int64_t(1), doc["a\"b"].get_int64());
+	CPPUNIT_ASSERT_EQUAL(int64_t(2), doc["\xc3\xa4"].get_int64());
+	CPPUNIT_ASSERT_EQUAL(int64_t(3), doc["\\"].get_int64());
+}
+
+void test::test_missing()
+{
+	std::string data("{\"a\": {\"b\": 1}, \"c\": [1]}");
+	Json::LazyDocument doc;
+	parse(doc, data);
+
+	CPPUNIT_ASSERT(!doc["x"]);
+	CPPUNIT_ASSERT(!doc["x"]["y"]);
+	CPPUNIT_ASSERT(!doc["a"][0]);
+	CPPUNIT_ASSERT(!doc["c"]["b"]);
+	CPPUNIT_ASSERT(!doc["c"][1]);
+	CPPUNIT_ASSERT(!doc["a"]["b"]["c"]);
+}
+
+void test::test_tags()
+{
+	std::string data("[null, true, false, 1, \"s\", [], {}]");
+	Json::LazyDocument doc;
+	parse(doc, data);
+
+	CPPUNIT_ASSERT_EQUAL(Json::Value::TAG_NULL, doc[0].tag());
+	CPPUNIT_ASSERT(doc[0].is_null());
+	CPPUNIT_ASSERT_EQUAL(Json::Value::TAG_TRUE, doc[1].tag());
+	CPPUNIT_ASSERT_EQUAL(Json::Value::TAG_FALSE, doc[2].tag());
+	CPPUNIT_ASSERT_EQUAL(Json::Value::TAG_NUMBER, doc[3].tag());
+	CPPUNIT_ASSERT_EQUAL(Json::Value::TAG_STRING, doc[4].tag());
+	CPPUNIT_ASSERT_EQUAL(Json::Value::TAG_ARRAY, doc[5].tag());
+	CPPUNIT_ASSERT_EQUAL(Json::Value::TAG_OBJECT, doc[6].tag());
+	CPPUNIT_ASSERT_EQUAL(Json::Value::TAG_INVALID, doc[7].tag());
+}
+
+void test::test_getters()
+{
+	std::string data("{\"i\":-12,\"f\":2.5e1,\"s\":\"x\\ny\",\"b\":false}");
+	Json::LazyDocument doc;
+	parse(doc, data);
+
+	CPPUNIT_ASSERT_EQUAL(int64_t(-12), doc["i"].get_int64());
+	CPPUNIT_ASSERT_EQUAL(-12.0, doc["i"].get_double());
+	CPPUNIT_ASSERT_EQUAL(25.0, doc["f"].get_double());
+	CPPUNIT_ASSERT_EQUAL(std::string("x\ny"), doc["s"].get_string());
+	CPPUNIT_ASSERT_EQUAL(false, doc["b"].get_bool());
+}
+
+void test::test_type_mismatch()
+{
+	std::string data("{\"f\": 1.5, \"s\": \"1\"}");
+	Json::LazyDocument doc;
+	parse(doc, data);
+
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(doc["f"].get_int64(), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::UNEXPECTED_EVENT, error.type);
+	CPPUNIT_ASSERT_THROW_VAR(doc["s"].get_double(), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::UNEXPECTED_EVENT, error.type);
+	CPPUNIT_ASSERT_THROW_VAR(doc["s"].get_bool(), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::UNEXPECTED_EVENT, error.type);
+	CPPUNIT_ASSERT_THROW_VAR(doc["x"].get_string(), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::UNEXPECTED_EVENT, error.type);
+	CPPUNIT_ASSERT_THROW_VAR(doc["x"].value(), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::UNEXPECTED_EVENT, error.type);
+}
+
+void test::test_value()
+{
+	std::string data("{\"a\": [1, 2.5, true, null, \"str\", {\"b\": []}], \"c\": 3}");
+	Json::LazyDocument doc;
+	parse(doc, data);
+
+	Json::Parser parser;
+	Json::Value expected(parser.parse(data.data(), data.size()));
+	CPPUNIT_ASSERT_EQUAL(expected, doc.root().value());
+	CPPUNIT_ASSERT_EQUAL(expected.as_object().as_member("a"), doc["a"].value());
+	CPPUNIT_ASSERT_EQUAL(Json::Value(2.5), doc["a"][1].value());
+	CPPUNIT_ASSERT_EQUAL(Json::Value(Json::Null()), doc["a"][3].value());
+	CPPUNIT_ASSERT_EQUAL(Json::Value("str"), doc["a"][4].value());
+}
+
+void test::test_bad_document()
+{
+	Json::LazyDocument doc;
+	parse(doc, "[1]");
+
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(parse(doc, "{\"a\": [1 2]}"), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::BAD_TOKEN_ARRAY_VALUE, error.type);
+	CPPUNIT_ASSERT(!doc.root());
+}
+
+void test::test_reuse()
+{
+	std::string first("{\"a\": [[1]]}");
+	std::string second("[{\"a\": 2}]");
+
+	Json::LazyDocument doc;
+	parse(doc, first);
+	CPPUNIT_ASSERT_EQUAL(int64_t(1), doc["a"][0][0].get_int64());
+
+	parse(doc, second);
+	CPPUNIT_ASSERT_EQUAL(int64_t(2), doc[0]["a"].get_int64());
+
+	Json::LazyDocument moved(std::move(doc));
+	CPPUNIT_ASSERT_EQUAL(int64_t(2), moved[0]["a"].get_int64());
+}
+
+}}
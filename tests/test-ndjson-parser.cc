@@ -0,0 +1,195 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+#include <vector>
+
+#include <jsoncc-cppunit.h>
+#include "error-io.h"
+
+namespace unittests {
+namespace ndjson_parser {
+
+class test : public CppUnit::TestCase {
+public:
+	test();
+	void setUp();
+	void tearDown();
+
+private:
+	void test_empty();
+	void test_lines();
+	void test_blank_lines();
+	void test_errors();
+	void test_ordered_many();
+	void test_unordered_many();
+	void test_long_lines();
+	void test_max_depth();
+	void test_callback_throws();
+
+	CPPUNIT_TEST_SUITE(test);
+	CPPUNIT_TEST(test_empty);
+	CPPUNIT_TEST(test_lines);
+	CPPUNIT_TEST(test_blank_lines);
+	CPPUNIT_TEST(test_errors);
+	CPPUNIT_TEST(test_ordered_many);
+	CPPUNIT_TEST(test_unordered_many);
+	CPPUNIT_TEST(test_long_lines);
+	CPPUNIT_TEST(test_max_depth);
+	CPPUNIT_TEST(test_callback_throws);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test);
+
+typedef Json::NdjsonParser::Record Record;
+
+std::vector<Record> parse(Json::NdjsonParser & parser, std::string const& data)
+{
+	std::vector<Record> res;
+	parser.parse(data.data(), data.size(), [&res](Record & record) {
+		res.push_back(std::move(record));
+	});
+	return res;
+}
+
+// one record per line, line i has id i
+std::string make_lines(size_t count)
+{
+	std::string res;
+	for (size_t i(1); i <= count; ++i) {
+		res += "{\"id\": " + std::to_string(i) + ", \"pad\": \"some text to fill the lines\"}\n";
+	}
+	return res;
+}
+
+test::test()
+{ }
+
+void test::setUp()
+{ }
+
+void test::tearDown()
+{ }
+
+void test::test_empty()
+{
+	Json::NdjsonParser parser;
+	CPPUNIT_ASSERT(parse(parser, "").empty());
+	CPPUNIT_ASSERT(parse(parser, "\n \n").empty());
+}
+
+void test::test_lines()
+{
+	Json::NdjsonParser parser(2);
+	auto records(parse(parser, "{\"a\": 1}\n[2]\r\n{}"));
+
+	CPPUNIT_ASSERT_EQUAL(size_t(3), records.size());
+	CPPUNIT_ASSERT_EQUAL(size_t(1), records[0].line);
+	CPPUNIT_ASSERT_EQUAL(Json::Value(Json::Object{{"a", 1}}), records[0].value);
+	CPPUNIT_ASSERT(!records[0].error);
+	CPPUNIT_ASSERT_EQUAL(size_t(2), records[1].line);
+	CPPUNIT_ASSERT_EQUAL(Json::Value(Json::Array{2}), records[1].value);
+	CPPUNIT_ASSERT_EQUAL(size_t(3), records[2].line);
+	CPPUNIT_ASSERT_EQUAL(Json::Value(Json::Object()), records[2].value);
+}
+
+void test::test_blank_lines()
+{
+	Json::NdjsonParser parser;
+	auto records(parse(parser, "\n[1]\n\n  \n[2]\n"));
+
+	CPPUNIT_ASSERT_EQUAL(size_t(2), records.size());
+	CPPUNIT_ASSERT_EQUAL(size_t(2), records[0].line);
+	CPPUNIT_ASSERT_EQUAL(size_t(5), records[1].line);
+}
+
+void test::test_errors()
+{
+	Json::NdjsonParser parser;
+	auto records(parse(parser, "[1]\n[1,, 2]\n[3]\n"));
+
+	CPPUNIT_ASSERT_EQUAL(size_t(3), records.size());
+	CPPUNIT_ASSERT(!records[0].error);
+	CPPUNIT_ASSERT(!records[1].value);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::BAD_TOKEN_ARRAY_NEXT, records[1].error.type);
+	CPPUNIT_ASSERT_EQUAL(size_t(2), records[1].error.location.line);
+	CPPUNIT_ASSERT(!records[2].error);
+
+	auto bad(parse(parser, "[1]\n[\"\\x\"]\n"));
+	CPPUNIT_ASSERT_EQUAL(Json::Error::ESCAPE_INVALID, bad[1].error.type);
+	CPPUNIT_ASSERT_EQUAL(size_t(2), bad[1].error.location.line);
+	CPPUNIT_ASSERT_EQUAL(size_t(8), bad[1].error.location.offs);
+}
+
+void test::test_ordered_many()
+{
+	std::string data(make_lines(50000));
+	Json::NdjsonParser parser(4, Json::NdjsonParser::ORDERED);
+	auto records(parse(parser, data));
+
+	CPPUNIT_ASSERT_EQUAL(size_t(50000), records.size());
+	for (size_t i(0); i < records.size(); ++i) {
+		CPPUNIT_ASSERT_EQUAL(i + 1, records[i].line);
+		CPPUNIT_ASSERT_EQUAL(int64_t(i + 1),
+			records[i].value.as_object().as_member("id").number().int_value());
+	}
+}
+
+void test::test_unordered_many()
+{
+	std::string data(make_lines(50000));
+	Json::NdjsonParser parser(4, Json::NdjsonParser::UNORDERED);
+	auto records(parse(parser, data));
+
+	CPPUNIT_ASSERT_EQUAL(size_t(50000), records.size());
+	std::vector<bool> seen(records.size() + 1, false);
+	for (auto const& record : records) {
+		auto id(record.value.as_object().as_member("id").number().int_value());
+		CPPUNIT_ASSERT_EQUAL(record.line, size_t(id));
+		CPPUNIT_ASSERT(!seen[id]);
+		seen[id] = true;
+	}
+}
+
+void test::test_long_lines()
+{
+	// lines longer than a batch
+	std::string big("[\"" + std::string(600 * 1024, 'x') + "\"]\n");
+	std::string data("[1]\n" + big + "[2]\n" + big + "[3]");
+	Json::NdjsonParser parser(3);
+	auto records(parse(parser, data));
+
+	CPPUNIT_ASSERT_EQUAL(size_t(5), records.size());
+	for (size_t i(0); i < records.size(); ++i) {
+		CPPUNIT_ASSERT_EQUAL(i + 1, records[i].line);
+		CPPUNIT_ASSERT(records[i].value);
+	}
+	CPPUNIT_ASSERT_EQUAL(Json::Value(Json::Array{3}), records[4].value);
+}
+
+void test::test_max_depth()
+{
+	Json::NdjsonParser parser;
+	CPPUNIT_ASSERT_EQUAL(size_t(255), parser.max_depth());
+	parser.set_max_depth(1);
+
+	auto records(parse(parser, "[]\n[[]]\n"));
+	CPPUNIT_ASSERT(!records[0].error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::PARSER_OVERFLOW, records[1].error.type);
+}
+
+void test::test_callback_throws()
+{
+	std::string data(make_lines(20000));
+	Json::NdjsonParser parser(4);
+
+	size_t calls(0);
+	CPPUNIT_ASSERT_THROW(parser.parse(data.data(), data.size(), [&calls](Record &) {
+		if (++calls == 100) {
+			throw std::runtime_error("stop");
+		}
+	}), std::runtime_error);
+	CPPUNIT_ASSERT_EQUAL(size_t(100), calls);
+}
+
+}}
@@ -19,11 +19,19 @@ private:
 	void test_nested();
 	void test_nested_noindent();
 	void test_member();
+	void test_default_member();
 	void test_unknown_member();
 	void test_equality();
 	void test_iterators();
 	void test_list_initialization();
 	void test_move();
+	void test_as_member();
+	void test_as_members();
+	void test_large_member();
+	void test_large_duplicates();
+	void test_large_append();
+	void test_large_copy();
+	void test_large_document();
 
 	CPPUNIT_TEST_SUITE(test);
 	CPPUNIT_TEST(test_empty);
@@ -31,11 +39,19 @@ private:
 	CPPUNIT_TEST(test_nested);
 	CPPUNIT_TEST(test_nested_noindent);
 	CPPUNIT_TEST(test_member);
+	CPPUNIT_TEST(test_default_member);
 	CPPUNIT_TEST(test_unknown_member);
 	CPPUNIT_TEST(test_equality);
 	CPPUNIT_TEST(test_iterators);
 	CPPUNIT_TEST(test_list_initialization);
 	CPPUNIT_TEST(test_move);
+	CPPUNIT_TEST(test_as_member);
+	CPPUNIT_TEST(test_as_members);
+	CPPUNIT_TEST(test_large_member);
+	CPPUNIT_TEST(test_large_duplicates);
+	CPPUNIT_TEST(test_large_append);
+	CPPUNIT_TEST(test_large_copy);
+	CPPUNIT_TEST(test_large_document);
 	CPPUNIT_TEST_SUITE_END();
 };
 
@@ -139,6 +155,14 @@ void test::test_member()
 	CPPUNIT_ASSERT_EQUAL(Json::Value(5), o.member("bar"));
 }
 
+void test::test_default_member()
+{
+	Json::Member m;
+	CPPUNIT_ASSERT_EQUAL(Json::String(""), m.key());
+	CPPUNIT_ASSERT(m.as_key() == "");
+	CPPUNIT_ASSERT_EQUAL(Json::Value(), m.as_value());
+}
+
 void test::test_unknown_member()
 {
 	Json::Object o;
@@ -289,4 +313,128 @@ void test::test_move()
 	}
 }
 
+void test::test_as_member()
+{
+	Json::Object o;
+	o << Json::Member("foo", true);
+	o << Json::Member("bar", Json::Array{1, 2});
+	o << Json::Member("foo", false);
+
+	CPPUNIT_ASSERT_EQUAL(Json::Value(true), o.as_member("foo"));
+	CPPUNIT_ASSERT_EQUAL(Json::Value(), o.as_member("baz"));
+	CPPUNIT_ASSERT_EQUAL(&o.as_members()[1].as_value(), &o.as_member("bar"));
+	CPPUNIT_ASSERT_EQUAL(size_t(2), o.as_member("bar").as_array().size());
+
+	std::string key("bar");
+	CPPUNIT_ASSERT_EQUAL(Json::Value::TAG_ARRAY, o.as_member(key).tag());
+}
+
+void test::test_as_members()
+{
+	Json::Object o{
+		Json::Member("foo", true),
+		Json::Member("bar", 5),
+	};
+
+	Json::View<Json::Member> members(o.as_members());
+	CPPUNIT_ASSERT_EQUAL(size_t(2), members.size());
+	CPPUNIT_ASSERT(!members.empty());
+	CPPUNIT_ASSERT(members[0].as_key() == "foo");
+	CPPUNIT_ASSERT(members[1].as_key() == "bar");
+	CPPUNIT_ASSERT_EQUAL(Json::Value(5), members[1].as_value());
+
+	size_t count(0);
+	for (auto const& m: members) {
+		CPPUNIT_ASSERT_EQUAL(&*(o.begin() + count), &m);
+		++count;
+	}
+	CPPUNIT_ASSERT_EQUAL(size_t(2), count);
+
+	CPPUNIT_ASSERT(Json::Object().as_members().empty());
+}
+
+// large enough for a hash index
+Json::Object make_large(size_t size)
+{
+	Json::Object res;
+	for (size_t i(0); i < size; ++i) {
+		res << Json::Member("key" + std::to_string(i), int(i));
+	}
+	return res;
+}
+
+void test::test_large_member()
+{
+	Json::Object o(make_large(500));
+	for (size_t i(0); i < 500; ++i) {
+		CPPUNIT_ASSERT_EQUAL(Json::Value(int(i)), o.as_member("key" + std::to_string(i)));
+	}
+	CPPUNIT_ASSERT(!o.as_member("key500"));
+	CPPUNIT_ASSERT(!o.as_member(""));
+	CPPUNIT_ASSERT_EQUAL(Json::Value(7), o.member("key7"));
+
+	// the order is kept
+	size_t i(0);
+	for (auto const& m : o) {
+		CPPUNIT_ASSERT(m.as_key() == "key" + std::to_string(i++));
+	}
+}
+
+void test::test_large_duplicates()
+{
+	Json::Object o(make_large(Json::Object::index_threshold));
+	o << Json::Member("key3", "second") << Json::Member("dup", 1) << Json::Member("dup", 2);
+
+	CPPUNIT_ASSERT_EQUAL(Json::Value(3), o.as_member("key3"));
+	CPPUNIT_ASSERT_EQUAL(Json::Value(1), o.as_member("dup"));
+	CPPUNIT_ASSERT_EQUAL(Json::Object::index_threshold + 3, o.size());
+}
+
+void test::test_large_append()
+{
+	Json::Object o(make_large(Json::Object::index_threshold));
+	CPPUNIT_ASSERT_EQUAL(Json::Value(0), o.as_member("key0"));
+
+	// members added after the index was built
+	for (size_t i(Json::Object::index_threshold); i < 300; ++i) {
+		o << Json::Member("key" + std::to_string(i), int(i));
+		CPPUNIT_ASSERT_EQUAL(Json::Value(int(i)), o.as_member("key" + std::to_string(i)));
+		CPPUNIT_ASSERT_EQUAL(Json::Value(int(i / 2)), o.as_member("key" + std::to_string(i / 2)));
+	}
+}
+
+void test::test_large_copy()
+{
+	Json::Object o(make_large(100));
+	CPPUNIT_ASSERT_EQUAL(Json::Value(50), o.as_member("key50"));
+
+	Json::Object copy(o);
+	copy << Json::Member("extra", true);
+	CPPUNIT_ASSERT_EQUAL(Json::Value(true), copy.as_member("extra"));
+	CPPUNIT_ASSERT(!o.as_member("extra"));
+
+	Json::Object moved(std::move(copy));
+	CPPUNIT_ASSERT_EQUAL(Json::Value(99), moved.as_member("key99"));
+
+	o = moved;
+	CPPUNIT_ASSERT_EQUAL(Json::Value(true), o.as_member("extra"));
+	o = make_large(20);
+	CPPUNIT_ASSERT(!o.as_member("extra"));
+	CPPUNIT_ASSERT_EQUAL(Json::Value(19), o.as_member("key19"));
+}
+
+void test::test_large_document()
+{
+	std::stringstream ss;
+	ss << Json::Value(make_large(200));
+	std::string text("[" + ss.str() + "]");
+
+	Json::Parser parser;
+	Json::Document doc;
+	parser.parse(text.data(), text.size(), doc);
+	Json::Object const& o(doc.root().as_array().as_elements()[0].as_object());
+	CPPUNIT_ASSERT_EQUAL(Json::Value(123), o.as_member("key123"));
+	CPPUNIT_ASSERT(!o.as_member("key200"));
+}
+
 }}}
@@ -0,0 +1,210 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <jsoncc-cppunit.h>
+#include "error-assert.h"
+#include "error-io.h"
+
+namespace unittests {
+namespace parse_file {
+
+class test : public CppUnit::TestCase {
+public:
+	test();
+	void setUp();
+	void tearDown();
+
+private:
+	void test_value();
+	void test_document();
+	void test_handler();
+	void test_empty_file();
+	void test_parse_error();
+	void test_missing_file();
+	void test_directory();
+	void test_fifo();
+	void test_ndjson();
+
+	CPPUNIT_TEST_SUITE(test);
+	CPPUNIT_TEST(test_value);
+	CPPUNIT_TEST(test_document);
+	CPPUNIT_TEST(test_handler);
+	CPPUNIT_TEST(test_empty_file);
+	CPPUNIT_TEST(test_parse_error);
+	CPPUNIT_TEST(test_missing_file);
+	CPPUNIT_TEST(test_directory);
+	CPPUNIT_TEST(test_fifo);
+	CPPUNIT_TEST(test_ndjson);
+	CPPUNIT_TEST_SUITE_END();
+
+	void write(std::string const&);
+
+	std::string path_;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test);
+
+class Counter : public Json::Handler {
+public:
+	Counter()
+	:
+		values(0)
+	{ }
+
+	void null() { ++values; }
+	void boolean(bool) { ++values; }
+	void number(int64_t) { ++values; }
+	void number(double) { ++values; }
+	void string(Json::StringView) { ++values; }
+	void start_array() { }
+	void end_array() { }
+	void start_object() { }
+	void key(Json::StringView) { }
+	void end_object() { }
+
+	size_t values;
+};
+
+test::test()
+:
+	path_()
+{ }
+
+void test::setUp()
+{
+	char name[] = "/tmp/jsoncc-test-XXXXXX";
+	int fd(mkstemp(name));
+	CPPUNIT_ASSERT(fd >= 0);
+	close(fd);
+	path_ = name;
+}
+
+void test::tearDown()
+{
+	unlink(path_.c_str());
+}
+
+void test::write(std::string const& data)
+{
+	FILE *file(fopen(path_.c_str(), "w"));
+	CPPUNIT_ASSERT(file);
+	CPPUNIT_ASSERT_EQUAL(data.size(), fwrite(data.data(), 1, data.size(), file));
+	fclose(file);
+}
+
+void test::test_value()
+{
+	write("{\"a\": [1, 2.5, \"str\"]}\n");
+
+	Json::Parser parser;
+	CPPUNIT_ASSERT_EQUAL(
+		Json::Value(Json::Object{{"a", Json::Array{1, 2.5, "str"}}}),
+		parser.parse_file(path_));
+}
+
+void test::test_document()
+{
+	std::string data("[{\"key\": \"a long string value exceeding the local storage\"}]");
+	write(data);
+
+	Json::Parser parser;
+	Json::Document doc;
+	parser.parse_file(path_, doc);
+	CPPUNIT_ASSERT_EQUAL(parser.parse(data.data(), data.size()), doc.root());
+}
+
+void test::test_handler()
+{
+	write("[null, true, 1, 1.5, \"x\", {\"k\": []}]");
+
+	Json::Parser parser;
+	Counter counter;
+	parser.parse_file(path_, counter);
+	CPPUNIT_ASSERT_EQUAL(size_t(5), counter.values);
+}
+
+void test::test_empty_file()
+{
+	Json::Parser parser;
+	CPPUNIT_ASSERT(!parser.parse_file(path_));
+}
+
+void test::test_parse_error()
+{
+	write("[1,\n 2 3]");
+
+	Json::Parser parser;
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(parser.parse_file(path_), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::BAD_TOKEN_ARRAY_VALUE, error.type);
+}
+
+void test::test_missing_file()
+{
+	Json::Parser parser;
+	CPPUNIT_ASSERT_THROW(parser.parse_file(path_ + ".missing"), std::system_error);
+}
+
+void test::test_directory()
+{
+	Json::Parser parser;
+	CPPUNIT_ASSERT_THROW(parser.parse_file("/tmp"), std::system_error);
+}
+
+void test::test_fifo()
+{
+	unlink(path_.c_str());
+	CPPUNIT_ASSERT_EQUAL(0, mkfifo(path_.c_str(), 0600));
+
+	// more than one read() worth of data
+	std::string data("[");
+	for (size_t i(0); i < 50000; ++i) {
+		data += "1, ";
+	}
+	data += "2]";
+
+	std::thread writer([this, &data] {
+		FILE *file(fopen(path_.c_str(), "w"));
+		fwrite(data.data(), 1, data.size(), file);
+		fclose(file);
+	});
+
+	Json::Parser parser;
+	Json::Value value;
+	try {
+		value = parser.parse_file(path_);
+	} catch (...) {
+		writer.join();
+		throw;
+	}
+	writer.join();
+
+	CPPUNIT_ASSERT_EQUAL(size_t(50001), value.as_array().size());
+	CPPUNIT_ASSERT_EQUAL(Json::Value(2), value.as_array().as_elements()[50000]);
+}
+
+void test::test_ndjson()
+{
+	write("[1]\n\n{\"a\": 2}\n");
+
+	std::vector<Json::NdjsonParser::Record> records;
+	Json::NdjsonParser parser(2);
+	parser.parse_file(path_, [&records](Json::NdjsonParser::Record & record) {
+		records.push_back(std::move(record));
+	});
+
+	CPPUNIT_ASSERT_EQUAL(size_t(2), records.size());
+	CPPUNIT_ASSERT_EQUAL(size_t(1), records[0].line);
+	CPPUNIT_ASSERT_EQUAL(Json::Value(Json::Array{1}), records[0].value);
+	CPPUNIT_ASSERT_EQUAL(size_t(3), records[1].line);
+	CPPUNIT_ASSERT_EQUAL(Json::Value(Json::Object{{"a", 2}}), records[1].value);
+}
+
+}}
@@ -1,6 +1,10 @@
+#include <algorithm>
+#include <cfloat>
 #include <cstring>
+#include <vector>
 
 #include <jsoncc-cppunit.h>
+#include "alloc-count.h"
 #include "error-assert.h"
 #include "error-io.h"
 #include "parser-impl.h"
@@ -34,13 +38,25 @@ private:
 	void test_missing_seperator_simple_object();
 	void test_missing_next_key_object();
 	void test_empty_name();
+	void test_float_range();
 	void test_nested_object();
 	void test_unbalanced_nested_object();
 	void test_complex();
 	void test_max_nesting();
+	void test_set_max_depth();
+	void test_deep_nesting();
 	void test_error();
 	void test_parse_no_throw_fail();
 	void test_parse_no_throw_ok();
+	void test_nested_array_allocations();
+	void test_nested_object_allocations();
+	void test_document();
+	void test_document_reuse();
+	void test_document_error();
+	void test_document_growth();
+	void test_document_borrowed();
+	void test_document_insitu();
+	void test_document_insitu_allocations();
 
 	CPPUNIT_TEST_SUITE(test);
 	CPPUNIT_TEST(test_empty_document);
@@ -62,18 +78,57 @@ private:
 	CPPUNIT_TEST(test_missing_seperator_simple_object);
 	CPPUNIT_TEST(test_missing_next_key_object);
 	CPPUNIT_TEST(test_empty_name);
+	CPPUNIT_TEST(test_float_range);
 	CPPUNIT_TEST(test_nested_object);
 	CPPUNIT_TEST(test_unbalanced_nested_object);
 	CPPUNIT_TEST(test_complex);
 	CPPUNIT_TEST(test_max_nesting);
+	CPPUNIT_TEST(test_set_max_depth);
+	CPPUNIT_TEST(test_deep_nesting);
 	CPPUNIT_TEST(test_error);
 	CPPUNIT_TEST(test_parse_no_throw_fail);
 	CPPUNIT_TEST(test_parse_no_throw_ok);
+	CPPUNIT_TEST(test_nested_array_allocations);
+	CPPUNIT_TEST(test_nested_object_allocations);
+	CPPUNIT_TEST(test_document);
+	CPPUNIT_TEST(test_document_reuse);
+	CPPUNIT_TEST(test_document_error);
+	CPPUNIT_TEST(test_document_growth);
+	CPPUNIT_TEST(test_document_borrowed);
+	CPPUNIT_TEST(test_document_insitu);
+	CPPUNIT_TEST(test_document_insitu_allocations);
 	CPPUNIT_TEST_SUITE_END();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(test);
 
+std::string nested(size_t depth, std::string const& open,
+	std::string const& inner, std::string const& close)
+{
+	std::string res;
+	for (size_t i(0); i < depth; ++i) {
+		res += open;
+	}
+	res += inner;
+	for (size_t i(0); i < depth; ++i) {
+		res += close;
+	}
+	return res;
+}
+
+size_t parse_allocations(std::string const& data)
+{
+	// the frame stack of a parser is reused, warm it up
+	Json::ParserImpl parser;
+	parser.parse(data.data(), data.size());
+
+	size_t before(unittests::alloc_count());
+	Json::Value value(parser.parse(data.data(), data.size()));
+	size_t after(unittests::alloc_count());
+	CPPUNIT_ASSERT(value);
+	return after - before;
+}
+
 test::test()
 { }
 
@@ -386,6 +441,34 @@ void test::test_empty_name()
 	CPPUNIT_ASSERT_EQUAL(size_t(0), error.location.offs);
 }
 
+// floats are stored as double, anything beyond is rejected
+void test::test_float_range()
+{
+	Json::ParserImpl parser;
+
+	std::string max_text("[1.7976931348623157e308]");
+	Json::Value max(parser.parse(max_text.data(), max_text.size()));
+	CPPUNIT_ASSERT_EQUAL(static_cast<long double>(DBL_MAX),
+		max.as_array().as_elements()[0].number().fp_value());
+
+	std::string rounded_text("[5e31]");
+	Json::Value rounded(parser.parse(rounded_text.data(), rounded_text.size()));
+	CPPUNIT_ASSERT_EQUAL(static_cast<long double>(5e31),
+		rounded.as_array().as_elements()[0].number().fp_value());
+
+	std::string texts[] = {
+		"[1e400]",
+		"[1.7976931348623159e308]",
+		"[-1e400]",
+	};
+	for (auto const& text: texts) {
+		Json::Error error;
+		CPPUNIT_ASSERT_THROW_VAR(parser.parse(text.data(), text.size()),
+			Json::Error, error);
+		CPPUNIT_ASSERT_EQUAL(Json::Error::NUMBER_INVALID, error.type);
+	}
+}
+
 void test::test_nested_object()
 {
 	Json::ParserImpl parser;
@@ -491,6 +574,54 @@ void test::test_max_nesting()
 	CPPUNIT_ASSERT_EQUAL(size_t(0), error.location.offs);
 }
 
+void test::test_set_max_depth()
+{
+	Json::Parser parser;
+	CPPUNIT_ASSERT_EQUAL(size_t(255), parser.max_depth());
+
+	parser.set_max_depth(3);
+	CPPUNIT_ASSERT_EQUAL(size_t(3), parser.max_depth());
+
+	std::string data(nested(3, "[", "", "]"));
+	CPPUNIT_ASSERT_EQUAL(
+		Json::Value(Json::Array{Json::Array{Json::Array()}}),
+		parser.parse(data.data(), data.size()));
+
+	data = nested(3, "{\"key\": ", "[]", "}");
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(
+		parser.parse(data.data(), data.size()), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::PARSER_OVERFLOW, error.type);
+
+	// the parser is usable after an error
+	data = "[[1], {\"a\": 2}]";
+	CPPUNIT_ASSERT_EQUAL(
+		Json::Value(Json::Array{Json::Array{1}, Json::Object{{"a", 2}}}),
+		parser.parse(data.data(), data.size()));
+}
+
+void test::test_deep_nesting()
+{
+	Json::Parser parser;
+	parser.set_max_depth(100000);
+
+	std::string data(nested(10000, "[{\"key\": ", "null", "}]"));
+	Json::Value value(parser.parse(data.data(), data.size()));
+
+	size_t depth(0);
+	Json::Value const* v(&value);
+	while (v->tag() == Json::Value::TAG_ARRAY) {
+		v = &v->as_array().as_elements()[0].as_object().as_member("key");
+		++depth;
+	}
+	CPPUNIT_ASSERT_EQUAL(size_t(10000), depth);
+	CPPUNIT_ASSERT_EQUAL(Json::Value::TAG_NULL, v->tag());
+
+	Json::Document doc;
+	parser.parse(data.data(), data.size(), doc);
+	CPPUNIT_ASSERT_EQUAL(Json::Value::TAG_ARRAY, doc.root().tag());
+}
+
 void test::test_error()
 {
 	Json::Error error;
@@ -525,4 +656,183 @@ void test::test_parse_no_throw_ok()
 	CPPUNIT_ASSERT_EQUAL(Json::Error::OK, error.type);
 }
 
+void test::test_nested_array_allocations()
+{
+	// Every level must be built once and then moved into its parent.
+	// Copying a subtree into each ancestor would make this quadratic.
+	size_t a32(parse_allocations(nested(32, "[", "", "]")));
+	size_t a64(parse_allocations(nested(64, "[", "", "]")));
+	size_t a128(parse_allocations(nested(128, "[", "", "]")));
+
+	CPPUNIT_ASSERT_EQUAL(2 * (a64 - a32), a128 - a64);
+}
+
+void test::test_nested_object_allocations()
+{
+	size_t a32(parse_allocations(nested(32, "{\"key\": ", "{}", "}")));
+	size_t a64(parse_allocations(nested(64, "{\"key\": ", "{}", "}")));
+	size_t a128(parse_allocations(nested(128, "{\"key\": ", "{}", "}")));
+
+	CPPUNIT_ASSERT_EQUAL(2 * (a64 - a32), a128 - a64);
+}
+
+void test::test_document()
+{
+	std::string data("{\"a\": [1, 2.5, true, null, \"short\"], "
+		"\"long key exceeding the local storage\": "
+		"\"a long string value exceeding the local storage\", "
+		"\"nested\": {\"b\": [[], {}]}}");
+
+	Json::Parser parser;
+	Json::Document doc;
+	parser.parse(data.data(), data.size(), doc);
+	CPPUNIT_ASSERT_EQUAL(parser.parse(data.data(), data.size()), doc.root());
+
+	// copies are independent of the document
+	Json::Value copy(doc.root());
+	Json::Document moved(std::move(doc));
+	moved = Json::Document();
+	CPPUNIT_ASSERT_EQUAL(parser.parse(data.data(), data.size()), copy);
+}
+
+void test::test_document_reuse()
+{
+	std::string data("[" + nested(64, "{\"key\": [", "1, \"two\", 3.0", "]}") + "]");
+
+	Json::Parser parser;
+	Json::Document doc;
+	parser.parse(data.data(), data.size(), doc);
+	size_t capacity(doc.capacity());
+
+	// the arena of the first parse is reused
+	size_t before(unittests::alloc_count());
+	parser.parse(data.data(), data.size(), doc);
+	size_t after(unittests::alloc_count());
+
+	CPPUNIT_ASSERT_EQUAL(size_t(0), after - before);
+	CPPUNIT_ASSERT_EQUAL(capacity, doc.capacity());
+	CPPUNIT_ASSERT_EQUAL(parser.parse(data.data(), data.size()), doc.root());
+}
+
+void test::test_document_error()
+{
+	Json::Parser parser;
+	Json::Document doc;
+
+	char good[] = "[\"x\"]";
+	parser.parse(good, sizeof(good) - 1, doc);
+	CPPUNIT_ASSERT(doc.root());
+
+	char bad[] = "[\"x\",";
+	Json::Error error;
+	parser.parse(bad, sizeof(bad) - 1, doc, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::BAD_TOKEN_ARRAY_NEXT, error.type);
+	CPPUNIT_ASSERT(!doc.root());
+
+	parser.parse(good, sizeof(good) - 1, doc);
+	CPPUNIT_ASSERT_THROW_VAR(
+		parser.parse(bad, sizeof(bad) - 1, doc), Json::Error, error);
+	CPPUNIT_ASSERT(!doc.root());
+}
+
+void test::test_document_growth()
+{
+	std::string data("[");
+	for (size_t i(0); i < 100; ++i) {
+		data += "{\"k\": [1, 2, 3], \"l\": {\"m\": 4}},";
+	}
+	data += "[]]";
+
+	Json::Parser parser;
+	Json::Document doc;
+	parser.parse(data.data(), data.size(), doc);
+
+	// growing containers must not copy their elements to the heap
+	size_t before(unittests::alloc_count());
+	parser.parse(data.data(), data.size(), doc);
+	size_t after(unittests::alloc_count());
+
+	CPPUNIT_ASSERT_EQUAL(size_t(0), after - before);
+	CPPUNIT_ASSERT_EQUAL(parser.parse(data.data(), data.size()), doc.root());
+}
+
+void test::test_document_borrowed()
+{
+	std::string data("{\"long key exceeding the local storage\": "
+		"[\"a long string value exceeding the local storage\", "
+		"\"an escaped string \\n exceeding the local storage\", \"short\"]}");
+
+	Json::Parser parser;
+	Json::Document doc;
+	parser.parse_borrowed(data.data(), data.size(), doc);
+	Json::Value expected(parser.parse(data.data(), data.size()));
+	CPPUNIT_ASSERT_EQUAL(expected, doc.root());
+
+	char const *begin(data.data());
+	char const *end(data.data() + data.size());
+	auto in_input([begin, end](Json::StringView str) {
+		return str.data() >= begin && str.data() < end;
+	});
+
+	Json::Member const& member(doc.root().as_object().as_members()[0]);
+	CPPUNIT_ASSERT(in_input(member.as_key()));
+	Json::Array const& array(member.as_value().as_array());
+	CPPUNIT_ASSERT(in_input(array.as_elements()[0].as_string()));
+	CPPUNIT_ASSERT(!in_input(array.as_elements()[1].as_string()));
+	CPPUNIT_ASSERT(!in_input(array.as_elements()[2].as_string()));
+
+	// copies do not refer to the input
+	Json::Value copy(doc.root());
+	doc = Json::Document();
+	data.assign(data.size(), ' ');
+	CPPUNIT_ASSERT_EQUAL(expected, copy);
+}
+
+void test::test_document_insitu()
+{
+	std::string data("{\"an escaped key \\\"exceeding\\\" the local storage\": "
+		"[\"a long string value exceeding the local storage\", "
+		"\"an escaped string \\n\\u00e4 exceeding the local storage\", \"\\t\"]}");
+
+	Json::Parser parser;
+	Json::Value expected(parser.parse(data.data(), data.size()));
+
+	std::vector<char> buffer(data.begin(), data.end());
+	Json::Document doc;
+	parser.parse_insitu(buffer.data(), buffer.size(), doc);
+	CPPUNIT_ASSERT_EQUAL(expected, doc.root());
+
+	char const *begin(buffer.data());
+	char const *end(buffer.data() + buffer.size());
+	auto in_buffer([begin, end](Json::StringView str) {
+		return str.data() >= begin && str.data() < end && str.data()[str.size()] == '\0';
+	});
+
+	Json::Member const& member(doc.root().as_object().as_members()[0]);
+	CPPUNIT_ASSERT(in_buffer(member.as_key()));
+	Json::Array const& array(member.as_value().as_array());
+	CPPUNIT_ASSERT(in_buffer(array.as_elements()[0].as_string()));
+	CPPUNIT_ASSERT(in_buffer(array.as_elements()[1].as_string()));
+	CPPUNIT_ASSERT_EQUAL(std::string("\t"), array.as_elements()[2].as_string().str());
+}
+
+void test::test_document_insitu_allocations()
+{
+	std::string data("[" + nested(16, "{\"escaped \\\"key\\\" \\u00e4\": [",
+		"\"a long escaped string\\r\\n in the input\", \"x\"", "]}") + "]");
+	std::vector<char> buffer(data.begin(), data.end());
+
+	Json::Parser parser;
+	Json::Document doc;
+	parser.parse_insitu(buffer.data(), buffer.size(), doc);
+
+	std::copy(data.begin(), data.end(), buffer.begin());
+	size_t before(unittests::alloc_count());
+	parser.parse_insitu(buffer.data(), buffer.size(), doc);
+	size_t after(unittests::alloc_count());
+
+	CPPUNIT_ASSERT_EQUAL(size_t(0), after - before);
+	CPPUNIT_ASSERT_EQUAL(parser.parse(data.data(), data.size()), doc.root());
+}
+
 }}
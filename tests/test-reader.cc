@@ -0,0 +1,278 @@
+#include <string>
+#include <vector>
+
+#include <jsoncc-cppunit.h>
+#include "error-assert.h"
+#include "error-io.h"
+
+namespace unittests {
+namespace reader {
+
+class test : public CppUnit::TestCase {
+public:
+	test();
+	void setUp();
+	void tearDown();
+
+private:
+	void test_empty_document();
+	void test_events();
+	void test_peek_type();
+	void test_depth();
+	void test_read_values();
+	void test_read_mismatch();
+	void test_skip_value();
+	void test_skip_value_end();
+	void test_decode_struct();
+	void test_bad_token();
+	void test_trailing_garbage();
+	void test_max_depth();
+
+	CPPUNIT_TEST_SUITE(test);
+	CPPUNIT_TEST(test_empty_document);
+	CPPUNIT_TEST(test_events);
+	CPPUNIT_TEST(test_peek_type);
+	CPPUNIT_TEST(test_depth);
+	CPPUNIT_TEST(test_read_values);
+	CPPUNIT_TEST(test_read_mismatch);
+	CPPUNIT_TEST(test_skip_value);
+	CPPUNIT_TEST(test_skip_value_end);
+	CPPUNIT_TEST(test_decode_struct);
+	CPPUNIT_TEST(test_bad_token);
+	CPPUNIT_TEST(test_trailing_garbage);
+	CPPUNIT_TEST(test_max_depth);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test);
+
+test::test()
+{ }
+
+void test::setUp()
+{ }
+
+void test::tearDown()
+{ }
+
+void test::test_empty_document()
+{
+	std::string data(" ");
+	Json::Reader reader(data.data(), data.size());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::END, reader.next());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::END, reader.next());
+}
+
+void test::test_events()
+{
+	std::string data("{\"a\": [true, null, 1, 2.5, \"x\"], \"b\": {}}");
+	Json::Reader reader(data.data(), data.size());
+
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::START_OBJECT, reader.next());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::KEY, reader.next());
+	CPPUNIT_ASSERT_EQUAL(std::string("a"), reader.string().str());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::START_ARRAY, reader.next());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::BOOLEAN, reader.next());
+	CPPUNIT_ASSERT(reader.boolean());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::NULL_VALUE, reader.next());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::INT, reader.next());
+	CPPUNIT_ASSERT_EQUAL(int64_t(1), reader.int_value());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::FLOAT, reader.next());
+	CPPUNIT_ASSERT_EQUAL(2.5, reader.float_value());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::STRING, reader.next());
+	CPPUNIT_ASSERT_EQUAL(std::string("x"), reader.string().str());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::END_ARRAY, reader.next());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::KEY, reader.next());
+	CPPUNIT_ASSERT_EQUAL(std::string("b"), reader.string().str());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::START_OBJECT, reader.next());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::END_OBJECT, reader.next());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::END_OBJECT, reader.next());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::END, reader.next());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::END, reader.event());
+}
+
+void test::test_peek_type()
+{
+	std::string data("[\"first\", \"second\"]");
+	Json::Reader reader(data.data(), data.size());
+
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::START_ARRAY, reader.next());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::STRING, reader.next());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::STRING, reader.peek_type());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::STRING, reader.peek_type());
+
+	// the current value is kept
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::STRING, reader.event());
+	CPPUNIT_ASSERT_EQUAL(std::string("first"), reader.string().str());
+
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::STRING, reader.next());
+	CPPUNIT_ASSERT_EQUAL(std::string("second"), reader.string().str());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::END_ARRAY, reader.peek_type());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::END_ARRAY, reader.next());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::END, reader.next());
+}
+
+void test::test_depth()
+{
+	std::string data("[[1]]");
+	Json::Reader reader(data.data(), data.size());
+
+	CPPUNIT_ASSERT_EQUAL(size_t(0), reader.depth());
+	reader.next();
+	CPPUNIT_ASSERT_EQUAL(size_t(1), reader.depth());
+	reader.peek_type();
+	CPPUNIT_ASSERT_EQUAL(size_t(1), reader.depth());
+	reader.next();
+	CPPUNIT_ASSERT_EQUAL(size_t(2), reader.depth());
+	reader.next();
+	reader.peek_type();
+	CPPUNIT_ASSERT_EQUAL(size_t(2), reader.depth());
+	reader.next();
+	CPPUNIT_ASSERT_EQUAL(size_t(1), reader.depth());
+	reader.next();
+	CPPUNIT_ASSERT_EQUAL(size_t(0), reader.depth());
+}
+
+void test::test_read_values()
+{
+	std::string data("[null, false, -7, 7, 0.25, \"str\"]");
+	Json::Reader reader(data.data(), data.size());
+
+	reader.enter_array();
+	reader.read_null();
+	CPPUNIT_ASSERT_EQUAL(false, reader.read_bool());
+	CPPUNIT_ASSERT_EQUAL(int64_t(-7), reader.read_int());
+	CPPUNIT_ASSERT_EQUAL(7.0, reader.read_double());
+	CPPUNIT_ASSERT_EQUAL(0.25, reader.read_double());
+	CPPUNIT_ASSERT_EQUAL(std::string("str"), reader.read_string());
+	CPPUNIT_ASSERT(!reader.next_element());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::END, reader.next());
+}
+
+void test::test_read_mismatch()
+{
+	std::string data("[\"1\"]");
+	Json::Reader reader(data.data(), data.size());
+
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(reader.enter_object(), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::UNEXPECTED_EVENT, error.type);
+
+	CPPUNIT_ASSERT_THROW_VAR(reader.read_int(), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::UNEXPECTED_EVENT, error.type);
+	CPPUNIT_ASSERT_EQUAL(std::string("1"), reader.string().str());
+
+	CPPUNIT_ASSERT_THROW_VAR(reader.next_key(), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::UNEXPECTED_EVENT, error.type);
+}
+
+void test::test_skip_value()
+{
+	std::string data("{\"skip\": [1, {\"x\": [[]]}], \"scalar\": 1, \"keep\": 2}");
+	Json::Reader reader(data.data(), data.size());
+
+	reader.enter_object();
+	CPPUNIT_ASSERT(reader.next_key());
+	reader.skip_value();
+	CPPUNIT_ASSERT(reader.next_key());
+	reader.skip_value();
+	CPPUNIT_ASSERT(reader.next_key());
+	CPPUNIT_ASSERT_EQUAL(std::string("keep"), reader.string().str());
+	CPPUNIT_ASSERT_EQUAL(int64_t(2), reader.read_int());
+	CPPUNIT_ASSERT(!reader.next_key());
+	CPPUNIT_ASSERT_EQUAL(Json::Reader::END, reader.next());
+}
+
+void test::test_skip_value_end()
+{
+	std::string data("[]");
+	Json::Reader reader(data.data(), data.size());
+
+	reader.enter_array();
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(reader.skip_value(), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::UNEXPECTED_EVENT, error.type);
+}
+
+struct Point {
+	int64_t x;
+	int64_t y;
+};
+
+void test::test_decode_struct()
+{
+	std::string data("{\"points\": [{\"x\": 1, \"y\": 2, \"label\": \"a\"}, "
+		"{\"y\": 4, \"x\": 3}], \"more\": [1, 2, 3]}");
+	Json::Reader reader(data.data(), data.size());
+
+	std::vector<Point> points;
+	reader.enter_object();
+	while (reader.next_key()) {
+		if (reader.string() != "points") {
+			reader.skip_value();
+			continue;
+		}
+
+		reader.enter_array();
+		while (reader.next_element()) {
+			Point point = {0, 0};
+			reader.enter_object();
+			while (reader.next_key()) {
+				if (reader.string() == "x") {
+					point.x = reader.read_int();
+				} else if (reader.string() == "y") {
+					point.y = reader.read_int();
+				} else {
+					reader.skip_value();
+				}
+			}
+			points.push_back(point);
+		}
+	}
+
+	CPPUNIT_ASSERT_EQUAL(size_t(2), points.size());
+	CPPUNIT_ASSERT_EQUAL(int64_t(1), points[0].x);
+	CPPUNIT_ASSERT_EQUAL(int64_t(2), points[0].y);
+	CPPUNIT_ASSERT_EQUAL(int64_t(3), points[1].x);
+	CPPUNIT_ASSERT_EQUAL(int64_t(4), points[1].y);
+}
+
+void test::test_bad_token()
+{
+	std::string data("{\"a\" 1}");
+	Json::Reader reader(data.data(), data.size());
+
+	reader.enter_object();
+	CPPUNIT_ASSERT(reader.next_key());
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(reader.next(), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::BAD_TOKEN_OBJECT_NAME, error.type);
+}
+
+void test::test_trailing_garbage()
+{
+	std::string data("[] 1");
+	Json::Reader reader(data.data(), data.size());
+
+	reader.enter_array();
+	CPPUNIT_ASSERT(!reader.next_element());
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(reader.next(), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::BAD_TOKEN_DOCUMENT, error.type);
+}
+
+void test::test_max_depth()
+{
+	std::string data("[[[]]]");
+	Json::Reader reader(data.data(), data.size());
+	CPPUNIT_ASSERT_EQUAL(size_t(255), reader.max_depth());
+	reader.set_max_depth(2);
+
+	reader.enter_array();
+	reader.enter_array();
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(reader.next(), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::PARSER_OVERFLOW, error.type);
+}
+
+}}
@@ -0,0 +1,319 @@
+#include <string>
+
+#include <jsoncc-cppunit.h>
+#include "error-assert.h"
+#include "error-io.h"
+
+namespace unittests {
+namespace stream_parser {
+
+class test : public CppUnit::TestCase {
+public:
+	test();
+	void setUp();
+	void tearDown();
+
+private:
+	void test_empty();
+	void test_single_chunk();
+	void test_byte_by_byte();
+	void test_split_tokens();
+	void test_split_anywhere();
+	void test_several_documents();
+	void test_buffered();
+	void test_bad_token();
+	void test_bad_document_start();
+	void test_bad_utf8();
+	void test_same_errors();
+	void test_incomplete();
+	void test_max_depth();
+
+	CPPUNIT_TEST_SUITE(test);
+	CPPUNIT_TEST(test_empty);
+	CPPUNIT_TEST(test_single_chunk);
+	CPPUNIT_TEST(test_byte_by_byte);
+	CPPUNIT_TEST(test_split_tokens);
+	CPPUNIT_TEST(test_split_anywhere);
+	CPPUNIT_TEST(test_several_documents);
+	CPPUNIT_TEST(test_buffered);
+	CPPUNIT_TEST(test_bad_token);
+	CPPUNIT_TEST(test_bad_document_start);
+	CPPUNIT_TEST(test_bad_utf8);
+	CPPUNIT_TEST(test_same_errors);
+	CPPUNIT_TEST(test_incomplete);
+	CPPUNIT_TEST(test_max_depth);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test);
+
+void feed(Json::StreamParser & parser, std::string const& data)
+{
+	parser.feed(data.data(), data.size());
+}
+
+test::test()
+{ }
+
+void test::setUp()
+{ }
+
+void test::tearDown()
+{ }
+
+void test::test_empty()
+{
+	Json::StreamParser parser;
+	feed(parser, " \n");
+	parser.finish();
+
+	Json::Value value;
+	CPPUNIT_ASSERT(!parser.next(value));
+}
+
+void test::test_single_chunk()
+{
+	Json::StreamParser parser;
+	feed(parser, "{\"a\": [1, 2]}");
+
+	Json::Value value;
+	CPPUNIT_ASSERT(parser.next(value));
+	CPPUNIT_ASSERT_EQUAL(
+		Json::Value(Json::Object{{"a", Json::Array{1, 2}}}), value);
+	CPPUNIT_ASSERT(!parser.next(value));
+	parser.finish();
+}
+
+void test::test_byte_by_byte()
+{
+	std::string data("{\"key \\\"]}\": [true, -1.5e3, \"h\xc3\xa4llo\", {}], "
+		"\"esc\": \"\\u00e4\\\\\"}");
+
+	Json::Parser reference;
+	Json::Value expected(reference.parse(data.data(), data.size()));
+
+	Json::StreamParser parser;
+	Json::Value value;
+	for (size_t i(0); i < data.size(); ++i) {
+		CPPUNIT_ASSERT(!parser.next(value));
+		parser.feed(&data[i], 1);
+	}
+
+	CPPUNIT_ASSERT(parser.next(value));
+	CPPUNIT_ASSERT_EQUAL(expected, value);
+}
+
+void test::test_split_tokens()
+{
+	Json::StreamParser parser;
+	feed(parser, "[12");
+	feed(parser, "34, tr");
+	feed(parser, "ue, \"\xc3");
+	feed(parser, "\xa4\\");
+	feed(parser, "n\"]");
+
+	Json::Value value;
+	CPPUNIT_ASSERT(parser.next(value));
+	CPPUNIT_ASSERT_EQUAL(
+		Json::Value(Json::Array{1234, true, "\xc3\xa4\n"}), value);
+}
+
+void test::test_split_anywhere()
+{
+	std::string data("{\"k\\u00e4y\": [true, false, null, -12.5e-1, 123456789, "
+		"\"a\\n\\\"\xe2\x82\xac\xf0\x9f\x98\x80\"], \"e\": {}}");
+
+	Json::Parser reference;
+	Json::Value expected(reference.parse(data.data(), data.size()));
+
+	for (size_t i(0); i <= data.size(); ++i) {
+		Json::StreamParser parser;
+		parser.feed(data.data(), i);
+		parser.feed(data.data() + i, data.size() - i);
+		parser.finish();
+
+		Json::Value value;
+		CPPUNIT_ASSERT(parser.next(value));
+		CPPUNIT_ASSERT_EQUAL(expected, value);
+	}
+}
+
+void test::test_several_documents()
+{
+	Json::StreamParser parser;
+	feed(parser, "[1]\n{\"a\": 2}\n[");
+	feed(parser, "3]");
+
+	Json::Value value;
+	CPPUNIT_ASSERT(parser.next(value));
+	CPPUNIT_ASSERT_EQUAL(Json::Value(Json::Array{1}), value);
+	CPPUNIT_ASSERT(parser.next(value));
+	CPPUNIT_ASSERT_EQUAL(Json::Value(Json::Object{{"a", 2}}), value);
+	CPPUNIT_ASSERT(parser.next(value));
+	CPPUNIT_ASSERT_EQUAL(Json::Value(Json::Array{3}), value);
+	CPPUNIT_ASSERT(!parser.next(value));
+}
+
+void test::test_buffered()
+{
+	// complete tokens are not held
+	Json::StreamParser parser;
+	feed(parser, "[1] [2, ");
+	CPPUNIT_ASSERT_EQUAL(size_t(0), parser.buffered());
+	feed(parser, "\"ab\\u00");
+	CPPUNIT_ASSERT_EQUAL(size_t(2), parser.buffered());
+	feed(parser, "e4\", 12");
+	CPPUNIT_ASSERT_EQUAL(size_t(2), parser.buffered());
+	feed(parser, "3]");
+	CPPUNIT_ASSERT_EQUAL(size_t(0), parser.buffered());
+
+	Json::Value value;
+	CPPUNIT_ASSERT(parser.next(value));
+	CPPUNIT_ASSERT(parser.next(value));
+	CPPUNIT_ASSERT_EQUAL(Json::Value(Json::Array{2, "ab\xc3\xa4", 123}), value);
+}
+
+void test::test_bad_token()
+{
+	Json::StreamParser parser;
+	feed(parser, "[1] [1, ");
+
+	// reported before the document is complete
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(feed(parser, "x"), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::TOKEN_INVALID, error.type);
+	CPPUNIT_ASSERT_EQUAL(size_t(9), error.location.offs);
+
+	// a token that can not come next fails with its first char
+	Json::StreamParser other;
+	feed(other, "[1 ");
+	CPPUNIT_ASSERT_THROW_VAR(feed(other, "2"), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::BAD_TOKEN_ARRAY_VALUE, error.type);
+	CPPUNIT_ASSERT_EQUAL(size_t(4), error.location.offs);
+}
+
+void test::test_bad_document_start()
+{
+	Json::StreamParser parser;
+	feed(parser, "[] ");
+
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(feed(parser, "1"), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::BAD_TOKEN_DOCUMENT, error.type);
+
+	Json::StreamParser other;
+	CPPUNIT_ASSERT_THROW_VAR(feed(other, "]"), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::BAD_TOKEN_DOCUMENT, error.type);
+}
+
+void test::test_bad_utf8()
+{
+	Json::StreamParser parser;
+	feed(parser, "[\"\xe2");
+
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(feed(parser, "\x82\x28\"]"), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::UTF8_INVALID, error.type);
+	CPPUNIT_ASSERT_EQUAL(size_t(4), error.location.offs);
+
+	Json::StreamParser other;
+	feed(other, "[\"\xe2\x82");
+	CPPUNIT_ASSERT_THROW_VAR(feed(other, std::string("\0", 1)), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::STREAM_ZERO, error.type);
+	CPPUNIT_ASSERT_EQUAL(size_t(4), error.location.offs);
+}
+
+// fed byte by byte, the lexical errors are found where Parser finds them
+void test::test_same_errors()
+{
+	const char *texts[] = {
+		"[1 2]",
+		"[1,,2]",
+		"[tru]",
+		"[truefalse]",
+		"[nul",
+		"[1.]",
+		"[-]",
+		"[01]",
+		"[1e]",
+		"[1x]",
+		"[1e400]",
+		"[\"a\"b]",
+		"[\"abc\\\"]",
+		"[\"\\x\"]",
+		"[\"\\u12\"]",
+		"[\"\\u0000\"]",
+		"[\"\\ud800\"]",
+		"[\"a\x01\"]",
+		"[\"\xff\"]",
+		"[\"\xc3\"]",
+		"[\"\xc3",
+		"[\x01]",
+		"{\"a\" 1}",
+		"{\"\": 1}",
+		"{1: 2}",
+		"[1]]",
+		"[[1]",
+		"{\"a\": [}",
+		"]",
+		"1",
+	};
+
+	for (auto text : texts) {
+		std::string data(text);
+		Json::Error expected;
+		try {
+			Json::Parser().parse(data.data(), data.size());
+		} catch (Json::Error & e) {
+			expected = e;
+		}
+
+		Json::Error error;
+		try {
+			Json::StreamParser parser;
+			for (size_t i(0); i < data.size(); ++i) {
+				parser.feed(&data[i], 1);
+			}
+			parser.finish();
+		} catch (Json::Error & e) {
+			error = e;
+		}
+
+		CPPUNIT_ASSERT_EQUAL_MESSAGE(text, expected.type, error.type);
+		if (expected.location.offs) {
+			CPPUNIT_ASSERT_EQUAL_MESSAGE(text, expected.location.offs, error.location.offs);
+		}
+	}
+}
+
+void test::test_incomplete()
+{
+	Json::StreamParser parser;
+	feed(parser, "[\"abc");
+
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(parser.finish(), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::STRING_QUOTE, error.type);
+	CPPUNIT_ASSERT_EQUAL(size_t(5), error.location.offs);
+
+	Json::StreamParser other;
+	feed(other, "{\"a\": [1, 2]");
+	CPPUNIT_ASSERT_THROW_VAR(other.finish(), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::BAD_TOKEN_OBJECT_VALUE, error.type);
+	CPPUNIT_ASSERT_EQUAL(size_t(12), error.location.offs);
+}
+
+void test::test_max_depth()
+{
+	Json::StreamParser parser;
+	CPPUNIT_ASSERT_EQUAL(size_t(255), parser.max_depth());
+	parser.set_max_depth(2);
+	CPPUNIT_ASSERT_EQUAL(size_t(2), parser.max_depth());
+
+	feed(parser, "[[]]");
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(feed(parser, "[[["), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::PARSER_OVERFLOW, error.type);
+}
+
+}}
@@ -0,0 +1,292 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <jsoncc-cppunit.h>
+#include "error-assert.h"
+#include "error-io.h"
+#include "structural-index.h"
+
+namespace unittests {
+namespace structural_index {
+
+class test : public CppUnit::TestCase {
+public:
+	test();
+	void setUp();
+	void tearDown();
+
+private:
+	void test_backend();
+	void test_index();
+	void test_index_escapes();
+	void test_index_unterminated();
+	void test_same_values();
+	void test_same_errors();
+	void test_block_boundaries();
+	void test_mutations();
+	void test_document();
+
+	CPPUNIT_TEST_SUITE(test);
+	CPPUNIT_TEST(test_backend);
+	CPPUNIT_TEST(test_index);
+	CPPUNIT_TEST(test_index_escapes);
+	CPPUNIT_TEST(test_index_unterminated);
+	CPPUNIT_TEST(test_same_values);
+	CPPUNIT_TEST(test_same_errors);
+	CPPUNIT_TEST(test_block_boundaries);
+	CPPUNIT_TEST(test_mutations);
+	CPPUNIT_TEST(test_document);
+	CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(test);
+
+test::test()
+{ }
+
+void test::setUp()
+{ }
+
+void test::tearDown()
+{ }
+
+struct Outcome {
+	Json::Value value;
+	Json::Error error;
+};
+
+Outcome parse(std::string const& text, Json::Parser::Backend backend)
+{
+	Json::Parser parser;
+	parser.set_backend(backend);
+
+	Outcome res;
+	try {
+		res.value = parser.parse(text.data(), text.size());
+	} catch (Json::Error & e) {
+		res.error = e;
+	}
+	return res;
+}
+
+// both backends give the same tree or the same error
+void assert_same(std::string const& text)
+{
+	Outcome expected(parse(text, Json::Parser::TOKEN_STREAM));
+	Outcome result(parse(text, Json::Parser::STRUCTURAL_INDEX));
+
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(text, expected.error.type, result.error.type);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(text, expected.error.location.offs, result.error.location.offs);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(text, expected.error.location.line, result.error.location.line);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(text, expected.value, result.value);
+}
+
+std::vector<uint32_t> index(std::string const& text)
+{
+	std::vector<uint32_t> res;
+	Json::structural_index(text.data(), text.size(), res);
+	return res;
+}
+
+void test::test_backend()
+{
+	Json::Parser parser;
+	CPPUNIT_ASSERT_EQUAL(Json::Parser::TOKEN_STREAM, parser.backend());
+	parser.set_backend(Json::Parser::STRUCTURAL_INDEX);
+	CPPUNIT_ASSERT_EQUAL(Json::Parser::STRUCTURAL_INDEX, parser.backend());
+}
+
+void test::test_index()
+{
+	std::vector<uint32_t> expected{0, 1, 3, 4, 6, 7, 8, 10, 14, 15};
+	CPPUNIT_ASSERT(expected == index("{\"a\": [1, true]}"));
+
+	// no entries inside strings
+	expected = {0, 1, 7, 9, 11, 17};
+	CPPUNIT_ASSERT(expected == index("[\"{,: ]\" , -2.5e1]"));
+}
+
+void test::test_index_escapes()
+{
+	// an escaped quote is no entry, an escaped backslash is
+	const uint32_t decode(Json::index_decode);
+	std::vector<uint32_t> expected{0, 1 | decode, 4, 5, 6 | decode, 10, 11};
+	CPPUNIT_ASSERT(expected == index("[\"\\\"\",\"a\\\\\"]"));
+
+	expected = {0, 1 | decode, 5, 6, 7, 9, 10};
+	CPPUNIT_ASSERT(expected == index("[\"a\tb\",\"c\"]"));
+
+	// backslashes ending a block escape the next one
+	for (size_t run(1); run < 6; ++run) {
+		std::string text("[\"" + std::string(62 - run, 'x') +
+			std::string(run, '\\') + "\",1]");
+		if (run % 2) {
+			// the quote is escaped, the string goes on to the end
+			Json::Error error;
+			CPPUNIT_ASSERT_THROW_VAR(index(text), Json::Error, error);
+			CPPUNIT_ASSERT_EQUAL(Json::Error::STRING_QUOTE, error.type);
+		} else {
+			std::vector<uint32_t> expected{0, 1 | decode, 64, 65, 66, 67};
+			CPPUNIT_ASSERT(expected == index(text));
+		}
+	}
+}
+
+void test::test_index_unterminated()
+{
+	std::vector<uint32_t> entries;
+	std::string text("[\"abc");
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(
+		Json::structural_index(text.data(), text.size(), entries), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::STRING_QUOTE, error.type);
+
+	text = "[\"\xc3\"]";
+	CPPUNIT_ASSERT_THROW_VAR(
+		Json::structural_index(text.data(), text.size(), entries), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::UTF8_INVALID, error.type);
+}
+
+void test::test_same_values()
+{
+	const char *texts[] = {
+		"",
+		"   ",
+		"[]",
+		"{}",
+		" \t\r\n[ ] ",
+		"[1,2,3]",
+		"[-0, 0.5, 1e10, -1.25E-3, 9223372036854775807, -9223372036854775808]",
+		"[true,false,null]",
+		"{\"a\":{\"b\":[{},[],\"c\"]}}",
+		"{\"k\": \"\\\"quoted\\\" \\\\ \\/ \\b\\f\\n\\r\\t \\u00e4\"}",
+		"[\"h\xc3\xa4llo \xf0\x9f\x98\x80\"]",
+		"[\"\", \"a\", \"\\\\\", \"\\\\\\\\\"]",
+		"{\"dup\": 1, \"dup\": 2}",
+		"[1,]",
+		"[[[[[[[[[[1]]]]]]]]]]",
+	};
+
+	for (auto text : texts) {
+		assert_same(text);
+		CPPUNIT_ASSERT_MESSAGE(text, !parse(text, Json::Parser::STRUCTURAL_INDEX).error);
+	}
+}
+
+void test::test_same_errors()
+{
+	const char *texts[] = {
+		"1",
+		"\"str\"",
+		"[1 2]",
+		"[1,,2]",
+		"[tru]",
+		"[truefalse]",
+		"[true false]",
+		"[nul l]",
+		"[1.]",
+		"[-]",
+		"[01]",
+		"[1e]",
+		"[1x]",
+		"[\"a\"b]",
+		"[\"a\" \"b\"]",
+		"[\"abc",
+		"[\"abc\\\"]",
+		"[\"\\x\"]",
+		"[\"\\u12\"]",
+		"[\"\\u0000\"]",
+		"[\"\\ud800\"]",
+		"[\"a\x01\"]",
+		"[\"\xff\"]",
+		"[\x01]",
+		"{\"a\" 1}",
+		"{\"a\": 1 \"b\": 2}",
+		"{\"\": 1}",
+		"{1: 2}",
+		"{\"a\":}",
+		"[1]]",
+		"[1] [2]",
+		"[[1]",
+		"{\"a\": [}",
+		"[1.5e99999]",
+		"[123456789012345678901234567890]",
+	};
+
+	for (auto text : texts) {
+		assert_same(text);
+		CPPUNIT_ASSERT_MESSAGE(text, parse(text, Json::Parser::STRUCTURAL_INDEX).error);
+	}
+
+	std::string nul("[1, \0]", 6);
+	assert_same(nul);
+}
+
+void test::test_block_boundaries()
+{
+	// moves the tokens across the 64 byte blocks
+	const std::string tail("[\"esc\\\\\\\"aped\", \"" + std::string(70, 'x') +
+		"\", \"\\u00e4\", 1.5, true, null, {\"k\\\\\": -12}, \"\\\\\"]");
+	for (size_t pad(0); pad < 140; ++pad) {
+		assert_same(std::string(pad, ' ') + tail);
+		assert_same("[" + std::string(pad, '1') + "]");
+		assert_same("[\"" + std::string(pad, '\\') + "\"]");
+		assert_same("[\"" + std::string(pad, 'a') + "\\\"\", 1]");
+	}
+}
+
+// xorshift, for the same mutations on every run
+uint64_t next_random(uint64_t & state)
+{
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return state;
+}
+
+void test::test_mutations()
+{
+	const std::string seed("{\"id\": 12, \"name\": \"a \\\"b\\\" \\\\\", "
+		"\"list\": [1.5, -2, true, false, null, \"\\u00e4\"], "
+		"\"nested\": {\"k\": [[], {}]}, \"text\": \"" + std::string(50, 'y') + "\"}");
+	const char alphabet[] = "{}[]:,\"\\ 0123456789.-+eEtrufalsn\x01\xc3\xa4";
+
+	uint64_t state(0x9e3779b97f4a7c15);
+	for (size_t i(0); i < 2000; ++i) {
+		std::string text(seed);
+		for (size_t n(next_random(state) % 3 + 1); n; --n) {
+			size_t pos(next_random(state) % text.size());
+			char c(alphabet[next_random(state) % (sizeof(alphabet) - 1)]);
+			switch (next_random(state) % 3) {
+			case 0: text[pos] = c; break;
+			case 1: text.insert(pos, 1, c); break;
+			case 2: text.erase(pos, 1); break;
+			}
+		}
+		assert_same(text);
+	}
+}
+
+void test::test_document()
+{
+	std::string text("{\"a\": [\"x\", \"\\u00e4\", 1], \"b\": null}");
+	Json::Parser reference;
+	Json::Value expected(reference.parse(text.data(), text.size()));
+
+	Json::Parser parser;
+	parser.set_backend(Json::Parser::STRUCTURAL_INDEX);
+	Json::Document doc;
+	parser.parse(text.data(), text.size(), doc);
+	CPPUNIT_ASSERT_EQUAL(expected, Json::Value(doc.root()));
+
+	parser.parse_borrowed(text.data(), text.size(), doc);
+	CPPUNIT_ASSERT_EQUAL(expected, Json::Value(doc.root()));
+
+	std::string bad("{\"a\": [1 2]}");
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(parser.parse(bad.data(), bad.size(), doc), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::BAD_TOKEN_ARRAY_VALUE, error.type);
+}
+
+}}
@@ -79,6 +79,7 @@ private:
 	void test_float_exp_plus();
 	void test_float_double_dot();
 	void test_float_overflow();
+	void test_float_underflow();
 	void test_empty_string();
 	void test_unterminated_string();
 	void test_ascii_string();
@@ -91,6 +92,10 @@ private:
 	void test_utf8_incomplete_string();
 	void test_invalid_esc_string();
 	void test_eof();
+	void test_long_string();
+	void test_long_string_errors();
+	void test_int_limits();
+	void test_number_length();
 
 	CPPUNIT_TEST_SUITE(test);
 	CPPUNIT_TEST(test_stream_zero);
@@ -128,6 +133,7 @@ private:
 	CPPUNIT_TEST(test_float_exp_plus);
 	CPPUNIT_TEST(test_float_double_dot);
 	CPPUNIT_TEST(test_float_overflow);
+	CPPUNIT_TEST(test_float_underflow);
 	CPPUNIT_TEST(test_empty_string);
 	CPPUNIT_TEST(test_unterminated_string);
 	CPPUNIT_TEST(test_ascii_string);
@@ -140,6 +146,10 @@ private:
 	CPPUNIT_TEST(test_utf8_incomplete_string);
 	CPPUNIT_TEST(test_invalid_esc_string);
 	CPPUNIT_TEST(test_eof);
+	CPPUNIT_TEST(test_long_string);
+	CPPUNIT_TEST(test_long_string_errors);
+	CPPUNIT_TEST(test_int_limits);
+	CPPUNIT_TEST(test_number_length);
 	CPPUNIT_TEST_SUITE_END();
 };
 
@@ -502,7 +512,7 @@ void test::test_float_zero()
 	ts.scan();
 	CPPUNIT_ASSERT_EQUAL(Token::NUMBER, ts.token.type);
 	CPPUNIT_ASSERT_EQUAL(Token::FLOAT, ts.token.number_type);
-	CPPUNIT_ASSERT_EQUAL((long double)(0), ts.token.float_value);
+	CPPUNIT_ASSERT_EQUAL(double(0), ts.token.float_value);
 	ts.scan();
 	CPPUNIT_ASSERT_EQUAL(Token::END, ts.token.type);
 }
@@ -517,7 +527,7 @@ void test::test_float_zeros()
 	ts.scan();
 	CPPUNIT_ASSERT_EQUAL(Token::NUMBER, ts.token.type);
 	CPPUNIT_ASSERT_EQUAL(Token::FLOAT, ts.token.number_type);
-	CPPUNIT_ASSERT_EQUAL((long double)(0), ts.token.float_value);
+	CPPUNIT_ASSERT_EQUAL(double(0), ts.token.float_value);
 	ts.scan();
 	CPPUNIT_ASSERT_EQUAL(Token::END, ts.token.type);
 }
@@ -532,7 +542,7 @@ void test::test_float_neg_zero()
 	ts.scan();
 	CPPUNIT_ASSERT_EQUAL(Token::NUMBER, ts.token.type);
 	CPPUNIT_ASSERT_EQUAL(Token::FLOAT, ts.token.number_type);
-	CPPUNIT_ASSERT_EQUAL((long double)(0), ts.token.float_value);
+	CPPUNIT_ASSERT_EQUAL(double(0), ts.token.float_value);
 	ts.scan();
 	CPPUNIT_ASSERT_EQUAL(Token::END, ts.token.type);
 }
@@ -547,8 +557,8 @@ void test::test_float_number()
 	ts.scan();
 	CPPUNIT_ASSERT_EQUAL(Token::NUMBER, ts.token.type);
 	CPPUNIT_ASSERT_EQUAL(Token::FLOAT, ts.token.number_type);
-	long double delta(fabsl((long double)(1.000005) - ts.token.float_value));
-	CPPUNIT_ASSERT((long double)(1.0E-10) > delta);
+	double delta(fabs(double(1.000005) - ts.token.float_value));
+	CPPUNIT_ASSERT(double(1.0E-10) > delta);
 	ts.scan();
 	CPPUNIT_ASSERT_EQUAL(Token::END, ts.token.type);
 }
@@ -563,8 +573,8 @@ void test::test_float_exp_zero()
 	ts.scan();
 	CPPUNIT_ASSERT_EQUAL(Token::NUMBER, ts.token.type);
 	CPPUNIT_ASSERT_EQUAL(Token::FLOAT, ts.token.number_type);
-	long double delta(fabsl((long double)(1.5) - ts.token.float_value));
-	CPPUNIT_ASSERT((long double)(1.0E-10) > delta);
+	double delta(fabs(double(1.5) - ts.token.float_value));
+	CPPUNIT_ASSERT(double(1.0E-10) > delta);
 	ts.scan();
 	CPPUNIT_ASSERT_EQUAL(Token::END, ts.token.type);
 }
@@ -579,8 +589,8 @@ void test::test_float_exp_neg()
 	ts.scan();
 	CPPUNIT_ASSERT_EQUAL(Token::NUMBER, ts.token.type);
 	CPPUNIT_ASSERT_EQUAL(Token::FLOAT, ts.token.number_type);
-	long double delta(fabsl((long double)(1.5E-2) - ts.token.float_value));
-	CPPUNIT_ASSERT((long double)(1.0E-10) > delta);
+	double delta(fabs(double(1.5E-2) - ts.token.float_value));
+	CPPUNIT_ASSERT(double(1.0E-10) > delta);
 	ts.scan();
 	CPPUNIT_ASSERT_EQUAL(Token::END, ts.token.type);
 }
@@ -595,7 +605,7 @@ void test::test_float_exp_pos()
 	ts.scan();
 	CPPUNIT_ASSERT_EQUAL(Token::NUMBER, ts.token.type);
 	CPPUNIT_ASSERT_EQUAL(Token::FLOAT, ts.token.number_type);
-	CPPUNIT_ASSERT_EQUAL((long double)(1.5E2), ts.token.float_value);
+	CPPUNIT_ASSERT_EQUAL(double(1.5E2), ts.token.float_value);
 	ts.scan();
 	CPPUNIT_ASSERT_EQUAL(Token::END, ts.token.type);
 }
@@ -610,7 +620,7 @@ void test::test_float_exp_plus()
 	ts.scan();
 	CPPUNIT_ASSERT_EQUAL(Token::NUMBER, ts.token.type);
 	CPPUNIT_ASSERT_EQUAL(Token::FLOAT, ts.token.number_type);
-	CPPUNIT_ASSERT_EQUAL((long double)(1.5E2), ts.token.float_value);
+	CPPUNIT_ASSERT_EQUAL(double(1.5E2), ts.token.float_value);
 	ts.scan();
 	CPPUNIT_ASSERT_EQUAL(Token::END, ts.token.type);
 }
@@ -709,6 +719,21 @@ void test::test_float_overflow()
 	CPPUNIT_ASSERT_EQUAL(Json::Error::NUMBER_OVERFLOW, error.type);
 }
 
+void test::test_float_underflow()
+{
+	char data[] = "1e-400";
+	Utf8Stream us(data, sizeof(data) - 1);
+	TokenStream ts(us);
+
+	CPPUNIT_ASSERT_EQUAL(Token::INVALID, ts.token.type);
+	ts.scan();
+	CPPUNIT_ASSERT_EQUAL(Token::NUMBER, ts.token.type);
+	CPPUNIT_ASSERT_EQUAL(Token::FLOAT, ts.token.number_type);
+	CPPUNIT_ASSERT_EQUAL(0.0, ts.token.float_value);
+	ts.scan();
+	CPPUNIT_ASSERT_EQUAL(Token::END, ts.token.type);
+}
+
 void test::test_empty_string()
 {
 	char data[] = "\"\"";
@@ -876,4 +901,107 @@ void test::test_eof()
 	CPPUNIT_ASSERT_EQUAL(Token::END, ts.token.type);
 }
 
+void test::test_long_string()
+{
+	// put an escape and a multibyte char at every offset
+	// around the block boundaries of the scanner
+	for (size_t i(0); i < 70; ++i) {
+		std::string value(std::string(i, 'a') + "\\n" + std::string(70 - i, 'b') + "\xc3\xbc");
+		std::string data("\"" + value + "\"");
+		Utf8Stream us(data.data(), data.size());
+		TokenStream ts(us);
+
+		ts.scan();
+		CPPUNIT_ASSERT_EQUAL(Token::STRING, ts.token.type);
+		CPPUNIT_ASSERT_EQUAL(std::string(i, 'a') + "\n" + std::string(70 - i, 'b') + "\xc3\xbc",
+			ts.token.str_value);
+		ts.scan();
+		CPPUNIT_ASSERT_EQUAL(Token::END, ts.token.type);
+	}
+}
+
+void test::test_long_string_errors()
+{
+	struct {
+		const char *inject;
+		Json::Error::Type type;
+		size_t offs;
+	} cases[] = {
+		{"\x01", Json::Error::STRING_CTRL, 1},
+		{"\xa9", Json::Error::UTF8_INVALID, 0},
+		{"\xc3\"", Json::Error::UTF8_INVALID, 1},
+	};
+
+	for (auto const& c: cases) {
+		for (size_t i(0); i < 70; ++i) {
+			std::string data("\"" + std::string(i, 'a') + c.inject + std::string(40, 'b') + "\"");
+			Utf8Stream us(data.data(), data.size());
+			TokenStream ts(us);
+
+			Json::Error error;
+			CPPUNIT_ASSERT_THROW_VAR(ts.scan(), Json::Error, error);
+			CPPUNIT_ASSERT_EQUAL(c.type, error.type);
+			CPPUNIT_ASSERT_EQUAL(1 + i + c.offs, error.location.offs);
+		}
+	}
+}
+
+void test::test_int_limits()
+{
+	struct {
+		const char *data;
+		int64_t value;
+	} good[] = {
+		{"9223372036854775807", INT64_MAX},
+		{"-9223372036854775808", INT64_MIN},
+		{"-0", 0},
+		{"00", 0},
+	};
+
+	for (auto const& c: good) {
+		Utf8Stream us(c.data, strlen(c.data));
+		TokenStream ts(us);
+		ts.scan();
+		CPPUNIT_ASSERT_EQUAL(Token::INT, ts.token.number_type);
+		CPPUNIT_ASSERT_EQUAL(c.value, ts.token.int_value);
+	}
+
+	for (auto data: {"9223372036854775808", "-9223372036854775809",
+		"18446744073709551616", "100000000000000000000000000 "}) {
+		Utf8Stream us(data, strlen(data));
+		TokenStream ts(us);
+		Json::Error error;
+		CPPUNIT_ASSERT_THROW_VAR(ts.scan(), Json::Error, error);
+		CPPUNIT_ASSERT_EQUAL(Json::Error::NUMBER_INVALID, error.type);
+		CPPUNIT_ASSERT_EQUAL(strlen(data) - (data[strlen(data) - 1] == ' '), error.location.offs);
+	}
+
+	// integers out of range are fine as part of a float
+	char data[] = "100000000000000000000000000.5e-26";
+	Utf8Stream us(data, sizeof(data) - 1);
+	TokenStream ts(us);
+	ts.scan();
+	CPPUNIT_ASSERT_EQUAL(Token::FLOAT, ts.token.number_type);
+	CPPUNIT_ASSERT_EQUAL(double(1.000000000000000000000000005), ts.token.float_value);
+}
+
+void test::test_number_length()
+{
+	std::string data("1." + std::string(1020, '0') + "1");
+	CPPUNIT_ASSERT_EQUAL(size_t(1023), data.size());
+	Utf8Stream us(data.data(), data.size());
+	TokenStream ts(us);
+	ts.scan();
+	CPPUNIT_ASSERT_EQUAL(Token::FLOAT, ts.token.number_type);
+	CPPUNIT_ASSERT_EQUAL(double(1), ts.token.float_value);
+
+	data += "0";
+	Utf8Stream us2(data.data(), data.size());
+	TokenStream ts2(us2);
+	Json::Error error;
+	CPPUNIT_ASSERT_THROW_VAR(ts2.scan(), Json::Error, error);
+	CPPUNIT_ASSERT_EQUAL(Json::Error::NUMBER_OVERFLOW, error.type);
+	CPPUNIT_ASSERT_EQUAL(size_t(1024), error.location.offs);
+}
+
 }}
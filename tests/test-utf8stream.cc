@@ -1,5 +1,10 @@
 #include <cppunit/extensions/HelperMacros.h>
 
+#include <string>
+#include <vector>
+
+#include "error-assert.h"
+#include "error-io.h"
 #include "utf8stream.h"
 
 namespace unittests {
@@ -16,12 +21,16 @@ private:
 	void test_onebyte();
 	void test_simple();
 	void test_int_array();
+	void test_validate_differential();
+	void test_chunk_errors();
 
 	CPPUNIT_TEST_SUITE(test);
 	CPPUNIT_TEST(test_empty);
 	CPPUNIT_TEST(test_onebyte);
 	CPPUNIT_TEST(test_simple);
 	CPPUNIT_TEST(test_int_array);
+	CPPUNIT_TEST(test_validate_differential);
+	CPPUNIT_TEST(test_chunk_errors);
 	CPPUNIT_TEST_SUITE_END();
 };
 
@@ -100,4 +109,85 @@ void test::test_int_array()
 	CPPUNIT_ASSERT_EQUAL(int(','), us.getc());
 }
 
+void test::test_validate_differential()
+{
+	std::vector<std::string> fragments{
+		"a", "0123456789abcdefghij", "\"", " ",
+		"\xc3\xbc", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xf4\x8f\xbf\xbf",
+		// invalid: stray continuation, overlong, surrogate, too large
+		"\x80", "\xbf", "\xc0\xaf", "\xc1\xbf", "\xe0\x80\xaf", "\xed\xa0\x80",
+		"\xf0\x80\x80\xaf", "\xf4\x90\x80\x80", "\xf5\x80\x80\x80", "\xff",
+		// truncated sequences
+		"\xc3", "\xe2\x82", "\xf0\x9f\x98",
+		std::string(1, '\0'),
+	};
+
+	uint32_t seed(1);
+	auto random([&seed](size_t n) {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 8) % n;
+	});
+
+	for (size_t run(0); run < 20000; ++run) {
+		std::string data;
+		size_t count(random(40));
+		bool clean(random(2));
+		for (size_t i(0); i < count; ++i) {
+			// mostly valid input, errors late in the buffer
+			size_t n(clean && i + 1 < count ? 8 : fragments.size());
+			data += fragments[random(n)];
+		}
+
+		size_t expected_offs(data.size());
+		Json::Error::Type expected_type(Json::Error::OK);
+		Json::utf8validator utf8;
+		for (size_t i(0); i < data.size(); ++i) {
+			if (data[i] == '\0') {
+				expected_type = Json::Error::STREAM_ZERO;
+			} else if (!utf8.validate(static_cast<uint8_t>(data[i]))) {
+				expected_type = Json::Error::UTF8_INVALID;
+			} else {
+				continue;
+			}
+			expected_offs = i;
+			break;
+		}
+
+		for (size_t split(0); split <= data.size(); split += 16) {
+			Json::Error::Type type(Json::Error::OK);
+			size_t offs(Json::utf8_validate(data.data(), 0, split, type));
+			if (offs == split) {
+				offs = Json::utf8_validate(data.data(), split, data.size(), type);
+			}
+			CPPUNIT_ASSERT_EQUAL(expected_offs, offs);
+			CPPUNIT_ASSERT_EQUAL(expected_type, type);
+		}
+	}
+}
+
+void test::test_chunk_errors()
+{
+	// errors in later chunks are found at their exact offset,
+	// but only once the reader gets there
+	for (size_t offs: {size_t(0), size_t(70000), size_t(65535), size_t(65536), size_t(200001)}) {
+		std::string data(offs, 'x');
+		data += "\xe2\x82\xac\xe2\x82";
+		data += std::string(100000, 'y');
+
+		Utf8Stream us(data.data(), data.size());
+		for (size_t i(0); i < offs + 3; ++i) {
+			us.getc();
+		}
+		CPPUNIT_ASSERT_EQUAL(Utf8Stream::SGOOD, us.state());
+
+		StringView run(us.string_run());
+		CPPUNIT_ASSERT_EQUAL(size_t(2), run.size());
+		Json::Error error;
+		CPPUNIT_ASSERT_THROW_VAR(us.getc(), Json::Error, error);
+		CPPUNIT_ASSERT_EQUAL(Json::Error::UTF8_INVALID, error.type);
+		CPPUNIT_ASSERT_EQUAL(offs + 5, error.location.offs);
+		CPPUNIT_ASSERT_EQUAL(Utf8Stream::SBAD, us.state());
+	}
+}
+
 }}
@@ -1,7 +1,12 @@
 #include <cppunit/extensions/HelperMacros.h>
 #include <jsoncc.h>
 
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <jsoncc-cppunit.h>
+#include "alloc-count.h"
 
 // LCOV_EXCL_START
 std::ostream & operator<<(std::ostream & os, Json::Value::Tag tag)
@@ -40,6 +45,12 @@ private:
 	void test_string_type();
 	void test_object_type();
 	void test_array_type();
+	void test_reference_accessors();
+	void test_compact_layout();
+	void test_string_storage();
+	void test_assign_from_child();
+	void test_shared_payloads();
+	void test_shared_across_threads();
 
 	CPPUNIT_TEST_SUITE(test);
 	CPPUNIT_TEST(test_invalid_type);
@@ -51,6 +62,12 @@ private:
 	CPPUNIT_TEST(test_string_type);
 	CPPUNIT_TEST(test_object_type);
 	CPPUNIT_TEST(test_array_type);
+	CPPUNIT_TEST(test_reference_accessors);
+	CPPUNIT_TEST(test_compact_layout);
+	CPPUNIT_TEST(test_string_storage);
+	CPPUNIT_TEST(test_assign_from_child);
+	CPPUNIT_TEST(test_shared_payloads);
+	CPPUNIT_TEST(test_shared_across_threads);
 	CPPUNIT_TEST_SUITE_END();
 };
 
@@ -318,4 +335,156 @@ void test::test_array_type()
 	CPPUNIT_ASSERT_EQUAL(t1, t3);
 }
 
+void test::test_reference_accessors()
+{
+	Json::Value s(Json::String("foo"));
+	CPPUNIT_ASSERT_EQUAL(std::string("foo"), s.as_string().str());
+	CPPUNIT_ASSERT(s.as_string() == "foo");
+	CPPUNIT_ASSERT(s.as_string() != "bar");
+
+	Json::Value o(Json::Object{{"foo", true}});
+	CPPUNIT_ASSERT_EQUAL(size_t(1), o.as_object().size());
+	CPPUNIT_ASSERT_EQUAL(&o.as_object(), &o.as_object());
+
+	Json::Value a(Json::Array{1, 2, 3});
+	CPPUNIT_ASSERT_EQUAL(size_t(3), a.as_array().size());
+	CPPUNIT_ASSERT_EQUAL(&a.as_array(), &a.as_array());
+
+	// references stay with the value when it is moved
+	Json::Object const* ref(&o.as_object());
+	Json::Value moved(std::move(o));
+	CPPUNIT_ASSERT_EQUAL(ref, &moved.as_object());
+}
+
+void test::test_compact_layout()
+{
+	CPPUNIT_ASSERT(sizeof(Json::Value) <= 24);
+
+	size_t before(unittests::alloc_count());
+	{
+		Json::Value number(uint64_t(42));
+		Json::Value fp(1.5);
+		Json::Value str(Json::String("short string"));
+		Json::Value copy(str);
+		Json::Value moved(std::move(fp));
+		CPPUNIT_ASSERT_EQUAL(Json::Value::TAG_NUMBER, moved.tag());
+		CPPUNIT_ASSERT_EQUAL(Json::Value::TAG_INVALID, fp.tag());
+	}
+	CPPUNIT_ASSERT_EQUAL(before, unittests::alloc_count());
+}
+
+void test::test_string_storage()
+{
+	for (size_t len(0); len < 40; ++len) {
+		std::string in(len, 'x');
+		for (size_t i(0); i < len; ++i) {
+			in[i] = 'a' + i % 26;
+		}
+
+		Json::Value v((Json::String(in)));
+		CPPUNIT_ASSERT_EQUAL(in, v.as_string().str());
+		CPPUNIT_ASSERT_EQUAL(in, v.string().value());
+
+		Json::Value copy(v);
+		CPPUNIT_ASSERT_EQUAL(in, copy.as_string().str());
+		CPPUNIT_ASSERT(len <= 16 || copy.as_string().data() == v.as_string().data());
+
+		const char *data(v.as_string().data());
+		Json::Value moved(std::move(v));
+		CPPUNIT_ASSERT_EQUAL(in, moved.as_string().str());
+		CPPUNIT_ASSERT(len <= 16 || moved.as_string().data() == data);
+
+		copy = moved;
+		CPPUNIT_ASSERT_EQUAL(in, copy.as_string().str());
+		copy.set(Json::Null());
+		CPPUNIT_ASSERT_EQUAL(Json::Value::TAG_NULL, copy.tag());
+	}
+}
+
+void test::test_assign_from_child()
+{
+	Json::Value v(Json::Array{Json::Array{"a string that is stored on the heap", 1}});
+
+	v = v.as_array().as_elements()[0];
+	CPPUNIT_ASSERT_EQUAL(size_t(2), v.as_array().size());
+
+	Json::Value & child(const_cast<Json::Value &>(v.as_array().as_elements()[0]));
+	v = std::move(child);
+	CPPUNIT_ASSERT_EQUAL(std::string("a string that is stored on the heap"),
+		v.as_string().str());
+}
+
+void test::test_shared_payloads()
+{
+	Json::Value v(Json::Object{
+		{"list", Json::Array{1, 2, "a string that is stored on the heap"}},
+		{"name", "another string that is stored on the heap"},
+	});
+
+	size_t before(unittests::alloc_count());
+	Json::Value copy(v);
+	Json::Value assigned;
+	assigned = copy;
+	CPPUNIT_ASSERT_EQUAL(before, unittests::alloc_count());
+	CPPUNIT_ASSERT_EQUAL(&v.as_object(), &copy.as_object());
+	CPPUNIT_ASSERT_EQUAL(&v.as_object(), &assigned.as_object());
+
+	// the copies stay valid without the original
+	v = Json::Value();
+	CPPUNIT_ASSERT_EQUAL(copy, assigned);
+	CPPUNIT_ASSERT_EQUAL(std::string("another string that is stored on the heap"),
+		copy.as_object().as_member("name").as_string().str());
+
+	// changes go to a copy of the container, the members stay shared
+	Json::Object changed(copy.object());
+	changed << Json::Member("added", true);
+	Json::Value modified(std::move(changed));
+	CPPUNIT_ASSERT_EQUAL(size_t(2), copy.as_object().size());
+	CPPUNIT_ASSERT_EQUAL(size_t(3), modified.as_object().size());
+	CPPUNIT_ASSERT_EQUAL(&copy.as_object().as_member("list").as_array(),
+		&modified.as_object().as_member("list").as_array());
+
+	// a copy out of a Document is independent of its arena
+	Json::Parser parser;
+	Json::Document doc;
+	std::string text("{\"list\": [1, 2, \"a string that is stored on the heap\"]}");
+	parser.parse(text.data(), text.size(), doc);
+	Json::Value root(doc.root());
+	Json::Value root_copy(root);
+	CPPUNIT_ASSERT(&root.as_object() != &doc.root().as_object());
+	CPPUNIT_ASSERT_EQUAL(&root.as_object(), &root_copy.as_object());
+	doc = Json::Document();
+	CPPUNIT_ASSERT_EQUAL(copy.as_object().as_member("list"),
+		root_copy.as_object().as_member("list"));
+}
+
+void test::test_shared_across_threads()
+{
+	Json::Array elements;
+	for (int i(0); i < 100; ++i) {
+		elements << Json::Object{{"key", i}, {"text", std::string(40, 'a' + i % 26)}};
+	}
+	const Json::Value shared(std::move(elements));
+
+	std::vector<std::thread> threads;
+	std::vector<size_t> sizes(8);
+	for (auto & size : sizes) {
+		threads.emplace_back([&shared, &size] {
+			for (size_t i(0); i < 1000; ++i) {
+				Json::Value copy(shared);
+				Json::Value element(copy.as_array().as_elements()[i % 100]);
+				size += element.as_object().as_member("text").as_string().size();
+			}
+		});
+	}
+	for (auto & thread : threads) {
+		thread.join();
+	}
+
+	for (auto size : sizes) {
+		CPPUNIT_ASSERT_EQUAL(size_t(40000), size);
+	}
+	CPPUNIT_ASSERT_EQUAL(size_t(100), shared.as_array().size());
+}
+
 }}